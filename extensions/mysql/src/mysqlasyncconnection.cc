@@ -0,0 +1,264 @@
+#include "mysqlasyncconnection.hh"
+#include "mysqlexception.hh"
+
+namespace softeq
+{
+namespace db
+{
+namespace mysql
+{
+#include <mysql/mysql.h>
+
+MySqlAsyncConnection::MySqlAsyncConnection(const std::string &host, const int port, const std::string &userName,
+                                           const std::string &password, const std::string &database)
+    : _host(host)
+    , _port(port)
+    , _userName(userName)
+    , _password(password)
+    , _database(database)
+    , _session(mysql_init(nullptr))
+{
+    if (_session == nullptr)
+    {
+        throw MySqlException("Failed to initialize mysql client");
+    }
+}
+
+MySqlAsyncConnection::~MySqlAsyncConnection()
+{
+    if (_result != nullptr)
+    {
+        mysql_free_result(_result);
+    }
+    mysql_close(_session);
+}
+
+void MySqlAsyncConnection::submit(const SqlQuery &query, const Connection::parseFunc &fn, const Completion &done)
+{
+    Job job;
+    job.statements = query.buildStatement(_builder);
+    job.fn = fn;
+    job.done = done;
+    _jobs.push_back(std::move(job));
+}
+
+int MySqlAsyncConnection::socket() const
+{
+    return _state == State::Initial ? -1 : _session->net.fd;
+}
+
+bool MySqlAsyncConnection::busy() const
+{
+    return !_jobs.empty();
+}
+
+bool MySqlAsyncConnection::step()
+{
+    while (true)
+    {
+        net_async_status status = NET_ASYNC_COMPLETE;
+        switch (_state)
+        {
+        case State::Initial:
+        case State::Connecting:
+            _state = State::Connecting;
+            status = mysql_real_connect_nonblocking(_session, _host.c_str(), _userName.c_str(), _password.c_str(),
+                                                    _database.c_str(), _port, nullptr, 0);
+            if (status == NET_ASYNC_NOT_READY)
+            {
+                return false;
+            }
+            if (status == NET_ASYNC_ERROR)
+            {
+                _state = State::Failed;
+                MySqlException error(mysql_error(_session), "connect", mysql_errno(_session));
+                failAll(std::make_exception_ptr(error));
+                throw error;
+            }
+            _state = State::Idle;
+            break;
+
+        case State::Idle:
+        {
+            if (_jobs.empty())
+            {
+                return true;
+            }
+
+            Job &job = _jobs.front();
+            if (job.next == job.statements.size())
+            {
+                finishStatement(); // a query without statements
+                break;
+            }
+            try
+            {
+                _sqlText = job.statements[job.next].composeWithValues(
+                    [this](const SqlValue &value) { return literal(value); });
+            }
+            catch (...)
+            {
+                job.error = std::current_exception();
+                finishStatement();
+                break;
+            }
+            _state = State::Querying;
+            break;
+        }
+
+        case State::Querying:
+            status = mysql_real_query_nonblocking(_session, _sqlText.c_str(), _sqlText.length());
+            if (status == NET_ASYNC_NOT_READY)
+            {
+                return false;
+            }
+            if (status == NET_ASYNC_ERROR)
+            {
+                _jobs.front().error =
+                    std::make_exception_ptr(MySqlException(mysql_error(_session), _sqlText, mysql_errno(_session)));
+                finishStatement();
+                break;
+            }
+            if (mysql_field_count(_session) == 0)
+            {
+                finishStatement(); // no result set
+                break;
+            }
+            _state = State::StoringResult;
+            break;
+
+        case State::StoringResult:
+        {
+            status = mysql_store_result_nonblocking(_session, &_result);
+            if (status == NET_ASYNC_NOT_READY)
+            {
+                return false;
+            }
+            if (status == NET_ASYNC_ERROR || _result == nullptr)
+            {
+                _jobs.front().error =
+                    std::make_exception_ptr(MySqlException(mysql_error(_session), _sqlText, mysql_errno(_session)));
+                finishStatement();
+                break;
+            }
+
+            _header.clear();
+            MYSQL_FIELD *fields = mysql_fetch_fields(_result);
+            for (unsigned int i = 0; i < mysql_num_fields(_result); ++i)
+            {
+                _header[fields[i].name] = i;
+            }
+            _state = _jobs.front().fn ? State::Fetching : State::FreeingResult;
+            break;
+        }
+
+        case State::Fetching:
+        {
+            MYSQL_ROW row = nullptr;
+            status = mysql_fetch_row_nonblocking(_result, &row);
+            if (status == NET_ASYNC_NOT_READY)
+            {
+                return false;
+            }
+            if (status == NET_ASYNC_ERROR)
+            {
+                // the rows read so far are not a complete result, so the statement fails
+                _jobs.front().error =
+                    std::make_exception_ptr(MySqlException(mysql_error(_session), _sqlText, mysql_errno(_session)));
+                _state = State::FreeingResult;
+                break;
+            }
+            if (row == nullptr)
+            {
+                _state = State::FreeingResult; // the end of the result
+                break;
+            }
+
+            std::vector<const char *> values(row, row + mysql_num_fields(_result));
+            try
+            {
+                _jobs.front().fn(_header, values);
+            }
+            catch (...)
+            {
+                // the rest of the result is dropped
+                _jobs.front().error = std::current_exception();
+                _state = State::FreeingResult;
+            }
+            break;
+        }
+
+        case State::FreeingResult:
+            status = mysql_free_result_nonblocking(_result);
+            if (status == NET_ASYNC_NOT_READY)
+            {
+                return false;
+            }
+            _result = nullptr;
+            finishStatement();
+            break;
+
+        case State::Failed:
+            throw MySqlException("The session is not connected");
+        }
+    }
+}
+
+std::string MySqlAsyncConnection::literal(const SqlValue &value)
+{
+    switch (value.type())
+    {
+    case SqlValue::Subtype::Null:
+        return "NULL";
+
+    case SqlValue::Subtype::Integer:
+        return std::to_string(value.intValue());
+
+    case SqlValue::Subtype::String:
+    {
+        const std::string &text = value.strValue();
+        std::string escaped(text.length() * 2 + 1, '\0');
+        escaped.resize(mysql_real_escape_string(_session, &escaped[0], text.c_str(), text.length()));
+        return "'" + escaped + "'";
+    }
+
+    default:
+        throw SqlException("unsupported bind parameter");
+    }
+}
+
+void MySqlAsyncConnection::finishStatement()
+{
+    _state = State::Idle;
+
+    Job &job = _jobs.front();
+    if (!job.error && ++job.next < job.statements.size())
+    {
+        return;
+    }
+
+    // the job is removed before the completion, so it may submit new queries
+    Job done = std::move(job);
+    _jobs.pop_front();
+    if (done.done)
+    {
+        done.done(done.error);
+    }
+}
+
+void MySqlAsyncConnection::failAll(std::exception_ptr error)
+{
+    std::deque<Job> jobs;
+    jobs.swap(_jobs);
+    for (Job &job : jobs)
+    {
+        if (job.done)
+        {
+            job.done(error);
+        }
+    }
+}
+
+} // namespace mysql
+} // namespace db
+} // namespace softeq
@@ -1,6 +1,9 @@
 #include "mysqlconnection.hh"
 #include "mysqlexception.hh"
 
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <algorithm>
 #include <map>
@@ -12,6 +15,7 @@ namespace db
 namespace mysql
 {
 #include <mysql/mysql.h>
+#include <mysql/errmsg.h>
 
 MySqlConnection::MySqlConnection(const std::string &host, const int port, const std::string &userName,
                                  const std::string &password, const std::string &database)
@@ -22,16 +26,24 @@ MySqlConnection::MySqlConnection(const std::string &host, const int port, const
         throw MySqlException("Failed to initialize mysql client");
     }
 
+    // affected rows of an UPDATE are the matched ones (as Sqlite counts them), not only the ones with new values
     if (!mysql_real_connect(_session, host.c_str(), userName.c_str(), password.c_str(), database.c_str(), port, nullptr,
-                            0))
+                            CLIENT_FOUND_ROWS))
     {
+        std::string error = mysql_error(_session);
         mysql_close(_session);
-        throw MySqlException(mysql_error(_session));
+        throw MySqlException(error);
     }
+
+    readStatementLimits();
 }
 
 MySqlConnection::~MySqlConnection()
 {
+    if (_lastStatement != nullptr)
+    {
+        mysql_stmt_close(_lastStatement);
+    }
     if (_session != nullptr)
     {
         mysql_close(_session);
@@ -40,8 +52,27 @@ MySqlConnection::~MySqlConnection()
 
 namespace
 {
-constexpr static size_t defaultCellBufferSize = 100; /// Default return cell buffer size. if value is bigger
-                                                     /// implementation will allocate separate buffer for storing value
+/*!
+    \brief Checks if a statement is not supported by the prepared statement protocol
+    (the error is "This command is not supported in the prepared statement protocol yet")
+    \param sqlText statement text
+    \return true for transaction control statements and trigger definitions
+*/
+bool requiresTextProtocol(const std::string &sqlText)
+{
+    for (const char *prefix : {"START TRANSACTION", "SET TRANSACTION ", "SAVEPOINT ", "RELEASE SAVEPOINT ",
+                               "ROLLBACK TO SAVEPOINT ", "CREATE TRIGGER ", "DROP TRIGGER "})
+    {
+        if (sqlText.compare(0, std::strlen(prefix), prefix) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+constexpr static size_t defaultCellBufferSize = 100; /// Return cell buffer size if the longest value is not known.
+                                                     /// if value is bigger it will be re-fetched to separate buffer
 
 // Smart pointers for MySQL resource handling
 
@@ -121,323 +152,569 @@ void bindParameters(MYSQL_STMT *statement, std::vector<SqlValue> &parameters)
 }
 
 /*!
-    \brief Returns a header for MySQL statement 
-    \param statement MySQL statement
-    \returns column -> index map
+    \brief Writes decimal representation of an integer
+    \param value the value
+    \param negative true if the value is a magnitude of a negative number
+    \param out output buffer, at least 21 bytes
+    \returns the length of the representation
 */
-std::map<std::string, int> header(MYSQL_STMT *statement)
+std::size_t formatInteger(unsigned long long value, bool negative, char *out)
 {
-    std::map<std::string, int> columnsMap;
-
-    MysqlResultPtr resultStatement(mysql_stmt_result_metadata(statement));
-    if (!resultStatement)
+    char digits[20];
+    std::size_t count = 0;
+    do
     {
-        throw MySqlException(mysql_stmt_error(statement));
-    }
-
-    auto resultColumnCount = mysql_num_fields(resultStatement.get());
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
 
-    MYSQL_FIELD *fields = mysql_fetch_fields(resultStatement.get());
-    if (fields == nullptr)
+    std::size_t length = 0;
+    if (negative)
     {
-        throw MySqlException(mysql_stmt_error(statement));
+        out[length++] = '-';
     }
-
-    for (unsigned int i = 0; i < resultColumnCount; i++)
+    while (count > 0)
     {
-        columnsMap[fields[i].name] = i;
+        out[length++] = digits[--count];
     }
-
-    return columnsMap;
+    out[length] = '\0';
+    return length;
 }
 
-// this structure contains output buffers for mysql to fill
-struct FetchedColumnBuffers
-{
-    unsigned long length;
-    bool isNull;
-    char data[defaultCellBufferSize + 1] = {0};
-};
-
 /*!
-    \brief Fetches a row from executed MySQL statement. If buffers specified by 
-    resultColumns arguments are not big enough, the data should be re-fetched manually.
-    \param statement MySQL statement
-    \param resultColumns a vector of buffers used when binding values
-    \param rowVector output vector of string values
-    \returns true is there are more rows to fetch, false otherwise
+    \brief Per-statement storage for fetched rows. Integer columns are fetched in binary form and rendered to text
+    by the arena, which is cheaper than the formatting of the client library. Floating point and date/time columns
+    are fetched as text, so their values arrive exactly as the server formats them (e.g. DATETIME(3) fractions). Bind buffers of other columns
+    live in a single block which is sized from the result metadata once, and the same block is reused for every row.
+    If a value does not fit the buffer of its column anyway, the value is re-fetched into an overflow buffer
+    of the column which is reused for the next rows as well.
 */
-bool fetchRow(MYSQL_STMT *statement, const std::vector<FetchedColumnBuffers> &resultColumns,
-              std::vector<const char *> &rowVector)
+class RowArena
 {
-    auto resultColumnCount = rowVector.size();
+public:
+    /*!
+        \brief Binds result buffers to the statement
+        \param statement executed MySQL statement
+        \param maxLengthKnown true if the result was stored with STMT_ATTR_UPDATE_MAX_LENGTH set,
+        i.e. MYSQL_FIELD::max_length holds the longest value of the column
+    */
+    RowArena(MYSQL_STMT *statement, bool maxLengthKnown)
+        : _statement(statement)
+    {
+        MysqlResultPtr metadata(mysql_stmt_result_metadata(statement));
+        if (!metadata)
+        {
+            throw MySqlException(mysql_stmt_error(statement));
+        }
 
-    int res = mysql_stmt_fetch(statement);
+        auto columnCount = mysql_num_fields(metadata.get());
+        MYSQL_FIELD *fields = mysql_fetch_fields(metadata.get());
+        if (fields == nullptr)
+        {
+            throw MySqlException(mysql_stmt_error(statement));
+        }
 
-    if (res == MYSQL_NO_DATA)
-    {
-        return false; // wo do not have more rows
+        _columns.resize(columnCount);
+        _binds.resize(columnCount);
+
+        std::size_t storageSize = 0;
+        for (unsigned int i = 0; i < columnCount; i++)
+        {
+            _header[fields[i].name] = i;
+
+            Column &column = _columns[i];
+            column.bufferType = bufferType(fields[i].type);
+            column.isUnsigned = (fields[i].flags & UNSIGNED_FLAG) != 0;
+            if (column.bufferType == MYSQL_TYPE_STRING)
+            {
+                // one more byte for the terminating zero
+                column.offset = storageSize;
+                column.capacity = (maxLengthKnown ? fields[i].max_length : defaultCellBufferSize) + 1;
+                storageSize += column.capacity;
+            }
+        }
+        _storage.resize(storageSize);
+
+        for (unsigned int i = 0; i < columnCount; i++)
+        {
+            Column &column = _columns[i];
+            _binds[i].buffer_type = column.bufferType;
+            _binds[i].is_unsigned = column.isUnsigned;
+            _binds[i].length = &column.length;
+            _binds[i].is_null = &column.isNull;
+            switch (column.bufferType)
+            {
+            case MYSQL_TYPE_LONGLONG:
+                _binds[i].buffer = &column.integer;
+                break;
+            default:
+                _binds[i].buffer = _storage.data() + column.offset;
+                _binds[i].buffer_length = column.capacity;
+                break;
+            }
+        }
+
+        if (mysql_stmt_bind_result(statement, _binds.data()) != 0)
+        {
+            throw MySqlException(mysql_stmt_error(statement));
+        }
     }
 
-    if (res != 0 && res != MYSQL_DATA_TRUNCATED)
+    /*!
+        \brief Returns the header of the result
+        \returns column -> index map
+    */
+    const std::map<std::string, int> &header() const
     {
-        throw MySqlException(mysql_stmt_error(statement));
+        return _header;
     }
 
-    // vector of buffers for column values that need reallocation
-    std::vector<std::vector<char>> rowBuffer(resultColumnCount);
-
-    // go over the columns, check if the data is not truncated and store in rowVector
-    for (unsigned i = 0; i < resultColumnCount; ++i)
+    /*!
+        \brief Fetches the next row. Pointers stored in row are valid until the next call.
+        \param row output vector of string values, nullptr for NULL values
+        \returns true if a row was fetched, false if there are no more rows
+    */
+    bool fetch(std::vector<const char *> &row)
     {
-        if (resultColumns[i].isNull)
+        int res = mysql_stmt_fetch(_statement);
+
+        if (res == MYSQL_NO_DATA)
         {
-            rowVector[i] = nullptr;
+            return false; // wo do not have more rows
         }
-        else
-        {
-            // fetch again single column if we find that our buffer was not enough
-            if (resultColumns[i].length > sizeof(resultColumns[i].data) - 1)
-            {
-                MYSQL_BIND cellBind{};
-                rowBuffer.emplace_back(resultColumns[i].length + 1, 0);
 
-                cellBind.buffer_type = MYSQL_TYPE_STRING;
-                cellBind.buffer = rowBuffer.back().data();
-                cellBind.buffer_length = resultColumns[i].length + 1;
-
-                if (mysql_stmt_fetch_column(statement, &cellBind, i, 0) != 0)
-                {
-                    throw MySqlException(mysql_stmt_error(statement));
-                }
+        if (res != 0 && res != MYSQL_DATA_TRUNCATED)
+        {
+            throw MySqlException(mysql_stmt_error(_statement));
+        }
 
-                rowVector[i] = rowBuffer.back().data();
+        row.resize(_columns.size());
+        for (unsigned i = 0; i < _columns.size(); ++i)
+        {
+            Column &column = _columns[i];
+            if (column.isNull)
+            {
+                row[i] = nullptr;
+            }
+            else if (column.bufferType != MYSQL_TYPE_STRING)
+            {
+                row[i] = format(column);
+            }
+            else if (column.length < column.capacity)
+            {
+                _storage[column.offset + column.length] = '\0';
+                row[i] = _storage.data() + column.offset;
             }
             else
             {
-                rowVector[i] = resultColumns[i].data;
+                row[i] = refetch(i);
             }
         }
+        return true;
     }
-    return true; // continue with the next row
-}
 
-/*!
-    \brief Binds result buffers to the statement
-    \param statement MySQL statement
-    \param resultColumns vector of result column buffers to store information to
-*/
-void bindResults(MYSQL_STMT *statement, std::vector<FetchedColumnBuffers> &resultColumns)
-{
-    auto resultColumnCount = resultColumns.size();
-    std::vector<MYSQL_BIND> resultBinds(resultColumnCount);
+private:
+    struct Column;
 
-    for (size_t i = 0; i < static_cast<size_t>(resultColumnCount); i++)
+    /*!
+        \brief Chooses the type of the buffer to fetch values of a column to
+        \param fieldType the type of the column
+        \returns the type of the buffer
+    */
+    static enum_field_types bufferType(enum_field_types fieldType)
     {
-        resultBinds[i].buffer_type = MYSQL_TYPE_STRING;
-        resultBinds[i].buffer = resultColumns[i].data;
-        resultBinds[i].buffer_length = sizeof(resultColumns[i].data);
-        resultBinds[i].length = &resultColumns[i].length;
-        resultBinds[i].is_null = &resultColumns[i].isNull;
+        switch (fieldType)
+        {
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_LONGLONG:
+        case MYSQL_TYPE_YEAR:
+            return MYSQL_TYPE_LONGLONG;
+        default:
+            return MYSQL_TYPE_STRING;
+        }
     }
 
-    if (mysql_stmt_bind_result(statement, resultBinds.data()) != 0)
+    /*!
+        \brief Renders an integer value to the text slot of the column
+        \param column the column
+        \returns the text
+    */
+    static const char *format(Column &column)
     {
-        throw MySqlException(mysql_stmt_error(statement));
+        if (column.isUnsigned || column.integer >= 0)
+        {
+            formatInteger(static_cast<unsigned long long>(column.integer), false, column.text);
+        }
+        else
+        {
+            // negate in unsigned arithmetic, so the minimal value does not overflow
+            formatInteger(0ull - static_cast<unsigned long long>(column.integer), true, column.text);
+        }
+        return column.text;
     }
-}
+
+    /*!
+        \brief Fetches a truncated value of a column again into the overflow buffer of the column
+        \param index index of the column
+        \returns the value
+    */
+    const char *refetch(unsigned index)
+    {
+        Column &column = _columns[index];
+        if (column.overflow.size() < column.length + 1)
+        {
+            column.overflow.resize(column.length + 1);
+        }
+
+        MYSQL_BIND cellBind{};
+        cellBind.buffer_type = MYSQL_TYPE_STRING;
+        cellBind.buffer = column.overflow.data();
+        cellBind.buffer_length = column.overflow.size();
+
+        if (mysql_stmt_fetch_column(_statement, &cellBind, index, 0) != 0)
+        {
+            throw MySqlException(mysql_stmt_error(_statement));
+        }
+        column.overflow[column.length] = '\0';
+        return column.overflow.data();
+    }
+
+    struct Column
+    {
+        enum_field_types bufferType = MYSQL_TYPE_STRING;
+        bool isUnsigned = false;
+        std::size_t offset = 0;   // offset of the column buffer in the storage (text columns)
+        std::size_t capacity = 0; // size of the column buffer (text columns)
+        unsigned long length = 0;
+        bool isNull = false;
+        std::vector<char> overflow; // buffer for values longer than capacity (text columns)
+
+        long long integer = 0; // integer columns are fetched here
+        char text[24];         // ... and rendered here
+    };
+
+    MYSQL_STMT *_statement;
+    std::map<std::string, int> _header;
+    std::vector<Column> _columns;
+    std::vector<MYSQL_BIND> _binds;
+    std::vector<char> _storage;
+};
 
 } // namespace
 
 void MySqlConnection::performImpl(const std::vector<Statement> &queries, const parseFunc &fn)
 {
+    std::uint64_t changedRows = 0;
+    setChangedRows(changedRows);
     for (auto line : queries) // NOTE: if parsing of some statement fails, the rest will not be executed. This is
                               // particularly bad for transactions
     {
         std::string sqlText = line.compose();
+        auto parameters = line.parameters();
+
+        observe(sqlText, parameters, [this, &sqlText, &parameters, &fn, &line, &changedRows](StatementStats *stats) {
+            changedRows += executeStatement(sqlText, parameters, fn, line.fetchOptions(), stats);
+        });
+    }
+    setChangedRows(changedRows);
+}
+
+std::uint64_t MySqlConnection::executeStatement(const std::string &sqlText, std::vector<SqlValue> &parameters,
+                                       const parseFunc &fn, const FetchOptions &options, StatementStats *stats)
+{
+    Stopwatch stopwatch(stats != nullptr);
 
-        // MySQL has issue when executing "START TRANSACTION" expression as statement so we do it using mysql_query
-        // The error is "This command is not supported in the prepared statement protocol yet"
-        if (sqlText == "START TRANSACTION; ")
+    // MySQL can't prepare some statements (e.g. "START TRANSACTION"), so they are executed using mysql_query
+    if (requiresTextProtocol(sqlText))
+    {
+        int result = mysql_query(_session, sqlText.c_str());
+        if (result != 0)
         {
-            int result = mysql_query(_session, sqlText.c_str());
-            if (result != 0)
-            {
-                throw MySqlException(mysql_error(_session), sqlText);
-            }
-            continue;
+            throw MySqlException(mysql_error(_session), sqlText, mysql_errno(_session));
+        }
+        if (stats)
+        {
+            stats->execute = stopwatch.lap();
         }
+        return mysql_field_count(_session) == 0 ? mysql_affected_rows(_session) : 0;
+    }
 
-        // prepare statement
-        StatementPtr statement(mysql_stmt_init(_session));
+    // consecutive executions of the same text (e.g. chunks of a bulk insert) reuse the prepared statement
+    // the statement is owned by this call until it succeeds
+    StatementPtr statement(_lastStatement);
+    _lastStatement = nullptr;
+    if (!statement || _lastStatementText != sqlText)
+    {
+        statement.reset(mysql_stmt_init(_session));
         if (!statement.get())
         {
-            throw MySqlException(mysql_error(_session), sqlText);
+            throw MySqlException(mysql_error(_session), sqlText, mysql_errno(_session));
         }
 
         if (mysql_stmt_prepare(statement.get(), sqlText.c_str(), sqlText.length()) != 0)
         {
-            throw MySqlException(mysql_stmt_error(statement.get()), sqlText);
+            throw MySqlException(mysql_stmt_error(statement.get()), sqlText, mysql_stmt_errno(statement.get()));
         }
+        _lastStatementText = sqlText;
+    }
 
-        // bind parameters if any
-        auto parameters = line.parameters();
-        bindParameters(statement.get(), parameters);
+    // bind parameters if any
+    bindParameters(statement.get(), parameters);
+
+    // attributes are set every time, a reused statement may have been executed with other options
+    const bool streaming = options.mode == FetchOptions::Mode::Streaming;
+    unsigned long cursorType = streaming ? CURSOR_TYPE_READ_ONLY : CURSOR_TYPE_NO_CURSOR;
+    if (mysql_stmt_attr_set(statement.get(), STMT_ATTR_CURSOR_TYPE, &cursorType) != 0)
+    {
+        throw MySqlException(mysql_stmt_error(statement.get()), sqlText, mysql_stmt_errno(statement.get()));
+    }
+    if (streaming)
+    {
+        // rows are fetched through a read-only cursor, prefetchRows at a time
+        unsigned long prefetchRows = options.prefetchRows;
+        if (mysql_stmt_attr_set(statement.get(), STMT_ATTR_PREFETCH_ROWS, &prefetchRows) != 0)
+        {
+            throw MySqlException(mysql_stmt_error(statement.get()), sqlText, mysql_stmt_errno(statement.get()));
+        }
+    }
+    else
+    {
+        // let mysql_stmt_store_result() calculate the longest value of each column
+        bool updateMaxLength = true;
+        if (mysql_stmt_attr_set(statement.get(), STMT_ATTR_UPDATE_MAX_LENGTH, &updateMaxLength) != 0)
+        {
+            throw MySqlException(mysql_stmt_error(statement.get()), sqlText, mysql_stmt_errno(statement.get()));
+        }
+    }
+
+    if (stats)
+    {
+        stats->prepare = stopwatch.lap();
+    }
+
+    // execute statement
+    if (mysql_stmt_execute(statement.get()) != 0)
+    {
+        throw MySqlException(mysql_stmt_error(statement.get()), sqlText, mysql_stmt_errno(statement.get()));
+    }
+
+    if (stats)
+    {
+        stats->execute = stopwatch.lap();
+    }
+
+    const std::uint64_t changedRows =
+        mysql_stmt_field_count(statement.get()) == 0 ? mysql_stmt_affected_rows(statement.get()) : 0;
 
-        // execute statement
-        if (mysql_stmt_execute(statement.get()) != 0)
+    // fetch and pass the result if any
+    if (fn)
+    {
+        // buffer the result on the client, so the longest values are known before binding
+        if (!streaming && mysql_stmt_store_result(statement.get()) != 0)
+        {
+            throw MySqlException(mysql_stmt_error(statement.get()), sqlText, mysql_stmt_errno(statement.get()));
+        }
+        if (stats)
         {
-            throw MySqlException(mysql_stmt_error(statement.get()), sqlText);
+            stats->fetch += stopwatch.lap();
         }
 
-        // fetch and pass the result if any
-        if (fn)
+        RowArena arena(statement.get(), !streaming);
+
+        // fetch rows
+        std::vector<const char *> rowVector;
+        while (arena.fetch(rowVector))
         {
-            // get metadata
-            std::map<std::string, int> columnsMap = header(statement.get());
-            auto columnCount = columnsMap.size();
+            if (stats)
+            {
+                stats->fetch += stopwatch.lap();
+            }
 
-            // bind result
-            std::vector<FetchedColumnBuffers> resultColumns(columnCount);
-            bindResults(statement.get(), resultColumns);
+            fn(arena.header(), rowVector); // submit results to fn
 
-            // fetch rows
-            std::vector<const char *> rowVector(columnCount);
-            while (fetchRow(statement.get(), resultColumns, rowVector))
+            if (stats)
             {
-                fn(columnsMap, rowVector); // submit results to fn
+                stats->deserialize += stopwatch.lap();
+                ++stats->rows;
             }
         }
+
+        if (stats)
+        {
+            stats->fetch += stopwatch.lap();
+        }
     }
+
+    // keep the statement for the next execution
+    mysql_stmt_free_result(statement.get());
+    _lastStatement = statement.release();
+    return changedRows;
 }
 
-MySqlQueryStringBuilder &MySqlConnection::queryBuilder()
+bool MySqlConnection::ping()
 {
-    return _builder;
+    return mysql_ping(_session) == 0;
 }
 
-void MySqlConnection::verifyScheme(const TableScheme &scheme)
+bool MySqlConnection::isConnectionError(const MySqlException &error)
 {
-    // TODO: it differs in some points from the implementation in sqlite, but looks similar in its structure. It's
-    // probably worth thinking about removing code duplication
-    std::map<std::string, Cell> expectedCells;
-    for (auto &&cell : scheme.cells())
-    {
-        expectedCells[cell.name()] = std::move(cell);
-    }
-
-    // Example of "describe 'tablename'" result:
-    // +-------+----------+------+-----+---------+----------------+
-    // | Field | Type     | Null | Key | Default | Extra          |
-    // +-------+----------+------+-----+---------+----------------+
-    // | id    | int      | NO   | PRI | NULL    | auto_increment |
-    // | name  | text     | NO   |     | NULL    |                |
-    // | age   | int      | YES  |     | NULL    |                |
-    // | date  | datetime | YES  |     | NULL    |                |
-    // +-------+----------+------+-----+---------+----------------+
-
-    auto processRow = [this, &expectedCells](const std::map<std::string, int> &header,
-                                             const std::vector<const char *> &row) {
-        auto fixNull = [](const char *ptr) { return ptr ? ptr : ""; };
-
-        constexpr const char *nameColumn = "Field";
-        constexpr const char *typeColumn = "Type";
-        constexpr const char *defaultColumn = "Default";
-        constexpr const char *nullColumn = "Null";
-        constexpr const char *primarykeyColumn = "Key";
-        constexpr const char *trueValue = "YES";
-        constexpr const char *primarykeyValue = "PRI";
+    return error.errorCode() == CR_SERVER_GONE_ERROR || error.errorCode() == CR_SERVER_LOST;
+}
 
-        auto iequal = [](const std::string &s, const std::string &t) {
-            if (s.length() != t.length())
-            {
-                return false;
-            }
+void MySqlConnection::readStatementLimits()
+{
+    if (mysql_query(_session, "SELECT @@max_allowed_packet") != 0)
+    {
+        throw MySqlException(mysql_error(_session));
+    }
+    MysqlResultPtr result(mysql_store_result(_session));
+    MYSQL_ROW row = result ? mysql_fetch_row(result.get()) : nullptr;
+    if (row == nullptr || row[0] == nullptr)
+    {
+        throw MySqlException("Failed to read max_allowed_packet");
+    }
 
-            for (size_t i = 0; i < s.length(); ++i)
-            {
-                if (std::tolower(s[i]) != std::tolower(t[i]))
-                {
-                    return false;
-                }
-            }
+    StatementLimits limits;
+    limits.maxParameters = 65535; // the protocol counts parameters in 2 bytes
+    // leave room for the packet header and binary encoding of the values
+    limits.maxLength = std::strtoull(row[0], nullptr, 10) / 10 * 9;
+    _builder.setStatementLimits(limits);
+}
 
-            return true;
+QueryPlan MySqlConnection::explainStatement(const std::string &sql, const std::vector<SqlValue> &parameters)
+{
+    QueryPlan plan;
+
+    // Example of "EXPLAIN ..." result:
+    // +----+-------------+-------+------+---------------+------+---------+------+------+----------------+
+    // | id | select_type | table | type | possible_keys | key  | key_len | ref  | rows | Extra          |
+    // +----+-------------+-------+------+---------------+------+---------+------+------+----------------+
+    // |  1 | SIMPLE      | t     | ALL  | NULL          | NULL | NULL    | NULL |   10 | Using filesort |
+    // +----+-------------+-------+------+---------------+------+---------+------+------+----------------+
+
+    auto processRow = [&plan](const std::map<std::string, int> &header, const std::vector<const char *> &row) {
+        auto column = [&header, &row](const char *name) -> std::string {
+            auto iter = header.find(name);
+            return iter != header.end() && row[iter->second] ? row[iter->second] : "";
         };
 
-        // info we get from actual (existing) table
-        const std::string name = fixNull(row[header.at(nameColumn)]);
-        const std::string type = fixNull(row[header.at(typeColumn)]);
-        const std::string defval = fixNull(row[header.at(defaultColumn)]);
-        const std::string isPK = fixNull(row[header.at(primarykeyColumn)]);
-        const std::string isNull = fixNull(row[header.at(nullColumn)]);
+        QueryPlan::Step step;
+        step.table = column("table");
+        step.index = column("key");
 
-        std::uint32_t flags = 0;
-        if (isPK == primarykeyValue)
+        const std::string type = column("type");
+        const std::string extra = column("Extra");
+        step.fullScan = type == "ALL";
+        if (extra.find("Using filesort") != std::string::npos)
         {
-            flags |= Cell::PRIMARY_KEY;
+            step.temporary = "ORDER BY";
         }
-
-        bool isNullable = false;
-        if (isNull == trueValue) // primary key is automatically not null
+        else if (extra.find("Using temporary") != std::string::npos)
         {
-            isNullable = true;
+            step.temporary = "TEMPORARY";
         }
 
-        auto cellp = expectedCells.find(name);
-        if (cellp == std::end(expectedCells))
-        {
-            throw SqlException("Column '" + name + "' does not exist in the scheme");
-        }
+        step.detail = column("select_type") + " " + step.table + " type=" + type + " key=" + step.index +
+                      " rows=" + column("rows") + (extra.empty() ? "" : " " + extra);
+        plan.steps.push_back(step);
+    };
 
-        Cell &cell = cellp->second;
+    // observers are not notified, so it is safe to call this method from an observer
+    std::string sqlText = "EXPLAIN " + sql;
+    std::vector<SqlValue> values = parameters;
+    executeStatement(sqlText, values, processRow, FetchOptions(), nullptr);
+    return plan;
+}
 
-        std::string expectedType = queryBuilder().cellRepr().type(cell.typeHash());
-        if (expectedType == "INTEGER")
-        {
-            expectedType = "int";
-        }
-        if (!iequal(type, expectedType))
-        {
-            throw SqlException("Type " + type + " of column '" + name + "' does not match type " + expectedType +
-                               " in scheme");
-        }
+MySqlQueryStringBuilder &MySqlConnection::queryBuilder()
+{
+    return _builder;
+}
 
-        if (defval != cell.config().toString() &&
-            !(defval == "<null>" && cell.config().type() == SqlValue::Subtype::Empty))
-        {
-            throw SqlException("Default value '" + defval + "' of column '" + name +
-                               "' does not match expected value " + cell.config().toString());
-        }
+std::vector<Connection::ColumnInfo> MySqlConnection::describeTables(const std::vector<std::string> &tables)
+{
+    std::vector<ColumnInfo> columns;
+    if (tables.empty())
+    {
+        return columns;
+    }
 
-        if (isNullable != cell.isNullable()) // check changes for nullable flag
-        {
-            throw SqlException("The value of the nullable flag for column '" + name + "' has value (" +
-                               std::to_string(isNullable) + ") and does not match expected (" +
-                               std::to_string(cell.isNullable()) + ")");
-        }
+    // Example of the result:
+    // +------------+-------------+-------------+---------------+-------------+------------+
+    // | table_name | column_name | column_type | default_value | is_nullable | column_key |
+    // +------------+-------------+-------------+---------------+-------------+------------+
+    // | student    | id          | int         | NULL          | NO          | PRI        |
+    // | student    | name        | text        | NULL          | NO          |            |
+    // +------------+-------------+-------------+---------------+-------------+------------+
+    auto processRow = [&columns](const std::map<std::string, int> &header, const std::vector<const char *> &row) {
+        auto fixNull = [](const char *ptr) { return ptr ? ptr : ""; };
+
+        constexpr const char *trueValue = "YES";
+        constexpr const char *primarykeyValue = "PRI";
+
+        ColumnInfo column;
+        column.table = fixNull(row[header.at("table_name")]);
+        column.name = fixNull(row[header.at("column_name")]);
+        column.type = fixNull(row[header.at("column_type")]);
+        column.defaultValue = fixNull(row[header.at("default_value")]);
+        column.nullable = std::string(fixNull(row[header.at("is_nullable")])) == trueValue;
+        column.primaryKey = std::string(fixNull(row[header.at("column_key")])) == primarykeyValue;
+        columns.push_back(std::move(column));
+    };
 
-        // NOTE: flag check does not check equivalence of flags, it check whether actual flags are included into
-        // expected ones. IMO it is more reasonable considering we can't get all flags.
-        // Moreover, probably PK should not be checked either since it can be set using constraints.
-        bool pkCheck = (isPK == primarykeyValue) == !!(cell.flags() & Cell::PRIMARY_KEY);
-        if (!pkCheck) // check only NOT NULL and PRIMARY KEY
+    std::vector<Token> statement{
+        Token("SELECT TABLE_NAME AS table_name, COLUMN_NAME AS column_name, COLUMN_TYPE AS column_type, "
+              "COLUMN_DEFAULT AS default_value, IS_NULLABLE AS is_nullable, COLUMN_KEY AS column_key "
+              "FROM information_schema.COLUMNS WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME IN (")};
+    for (auto iter = tables.begin(); iter != tables.end(); ++iter)
+    {
+        if (iter != tables.begin())
         {
-            throw SqlException("Parameters (" + std::to_string(flags) + ") of column '" + name +
-                               "' do not match expected parameters (" + std::to_string(cell.flags()) + ")");
+            statement.emplace_back(", ");
         }
+        statement.emplace_back(SqlValue(std::string(*iter)));
+    }
+    statement.emplace_back(") ORDER BY TABLE_NAME, ORDINAL_POSITION;");
 
-        expectedCells.erase(cellp); // checked - erase
-    };
+    performImpl({Statement(std::move(statement))}, processRow);
+    return columns;
+}
+
+bool MySqlConnection::sameType(const std::string &actual, const std::string &expected) const
+{
+    return sameMySqlType(actual, expected);
+}
 
-    std::string expression = "DESCRIBE " + scheme.name() + ";";
+bool MySqlConnection::sameDefault(const std::string &actual, const SqlValue &expected) const
+{
+    return sameMySqlDefault(actual, expected);
+}
 
-    performImpl({Statement(expression)}, processRow);
+bool MySqlConnection::sameMySqlType(const std::string &actual, const std::string &expected)
+{
+    std::string expectedType = expected == "INTEGER" ? "int" : expected;
+    if (actual.length() != expectedType.length())
+    {
+        return false;
+    }
 
-    if (!expectedCells.empty())
+    for (size_t i = 0; i < actual.length(); ++i)
     {
-        throw SqlException("Column '" + std::begin(expectedCells)->first + "' from scheme does not exist in the table");
+        if (std::tolower(actual[i]) != std::tolower(expectedType[i]))
+        {
+            return false;
+        }
     }
+
+    return true;
+}
+
+bool MySqlConnection::sameMySqlDefault(const std::string &actual, const SqlValue &expected)
+{
+    return actual == expected.toString() || (actual == "<null>" && expected.type() == SqlValue::Subtype::Empty);
 }
 
 } // namespace mysql
@@ -0,0 +1,408 @@
+#include "mysqlconnectionpool.hh"
+
+#include <dbfacade/transaction.hh>
+
+namespace softeq
+{
+namespace db
+{
+namespace mysql
+{
+#include <mysql/errmsg.h>
+
+namespace
+{
+/*!
+    \brief Checks if a statement only reads data, so it is safe to run it again
+    \param sqlText statement text
+    \return true for SELECT statements
+*/
+bool isRead(const std::string &sqlText)
+{
+    return sqlText.compare(0, 7, "SELECT ") == 0;
+}
+
+/*!
+    \brief Checks if a statement starts a transaction. SET TRANSACTION is sent right before START TRANSACTION
+    and affects the next transaction of the session only, so the session is pinned from it.
+    \param sqlText statement text
+    \return true for START TRANSACTION and SET TRANSACTION statements
+*/
+bool isBegin(const std::string &sqlText)
+{
+    return sqlText.compare(0, 17, "START TRANSACTION") == 0 || sqlText.compare(0, 16, "SET TRANSACTION ") == 0;
+}
+} // namespace
+
+MySqlConnectionPool::MySqlConnectionPool(const Options &options)
+    : _options(options)
+    , _commitText(CommitTransactionQuery().buildStatement(_builder).front().compose())
+    , _rollbackText(RollbackTransactionQuery().buildStatement(_builder).front().compose())
+{
+    if (_options.maxSessions == 0 || _options.minSessions > _options.maxSessions)
+    {
+        throw MySqlException("Invalid pool size");
+    }
+
+    // at least one session is opened to check the server is reachable and to learn its limits
+    for (std::size_t i = 0; i < std::max<std::size_t>(_options.minSessions, 1); ++i)
+    {
+        _idle.push_back(open());
+        ++_open;
+    }
+    _builder.setStatementLimits(_idle.front().connection->queryBuilder().statementLimits());
+
+    _maintenance = std::thread(&MySqlConnectionPool::maintain, this);
+}
+
+MySqlConnectionPool::~MySqlConnectionPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wakeMaintenance.notify_one();
+    _maintenance.join();
+}
+
+QueryPlan MySqlConnectionPool::explainStatement(const std::string &sql, const std::vector<SqlValue> &parameters)
+{
+    QueryPlan plan;
+    withSession(
+        sql, [](const MySqlException &) { return true; },
+        [&](MySqlConnection &session) { plan = session.explainStatement(sql, parameters); });
+    return plan;
+}
+
+std::unique_lock<std::recursive_mutex> MySqlConnectionPool::lease()
+{
+    return std::unique_lock<std::recursive_mutex>();
+}
+
+std::size_t MySqlConnectionPool::openSessions() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _open;
+}
+
+std::size_t MySqlConnectionPool::idleSessions() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _idle.size();
+}
+
+std::vector<Connection::ColumnInfo> MySqlConnectionPool::describeTables(const std::vector<std::string> &tables)
+{
+    std::vector<ColumnInfo> columns;
+    withSession(
+        std::string(), [](const MySqlException &) { return true; },
+        [&](MySqlConnection &session) { columns = session.describeTables(tables); });
+    return columns;
+}
+
+bool MySqlConnectionPool::sameType(const std::string &actual, const std::string &expected) const
+{
+    return MySqlConnection::sameMySqlType(actual, expected);
+}
+
+bool MySqlConnectionPool::sameDefault(const std::string &actual, const SqlValue &expected) const
+{
+    return MySqlConnection::sameMySqlDefault(actual, expected);
+}
+
+MySqlQueryStringBuilder &MySqlConnectionPool::queryBuilder()
+{
+    return _builder;
+}
+
+void MySqlConnectionPool::performImpl(const std::vector<Statement> &statements, const parseFunc &fn)
+{
+    std::uint64_t changedRows = 0;
+    setChangedRows(changedRows);
+    for (const Statement &line : statements)
+    {
+        std::string sqlText = line.compose();
+        auto parameters = line.parameters();
+
+        // rows passed to fn can't be taken back, so the statement is not retried after that
+        bool delivered = false;
+        parseFunc deliver;
+        if (fn)
+        {
+            deliver = [&fn, &delivered](const std::map<std::string, int> &header,
+                                        const std::vector<const char *> &row) {
+                delivered = true;
+                fn(header, row);
+            };
+        }
+
+        // a statement which did not reach the server or only reads data is safe to repeat
+        auto canRetry = [&sqlText, &delivered](const MySqlException &error) {
+            return !delivered && (error.errorCode() == CR_SERVER_GONE_ERROR || isRead(sqlText));
+        };
+
+        observe(sqlText, parameters, [&](StatementStats *stats) {
+            withSession(sqlText, canRetry, [&](MySqlConnection &session) {
+                changedRows += session.executeStatement(sqlText, parameters, deliver, line.fetchOptions(), stats);
+            });
+        });
+    }
+    setChangedRows(changedRows);
+}
+
+template <typename RetryT, typename FuncT>
+void MySqlConnectionPool::withSession(const std::string &sqlText, RetryT &&canRetry, FuncT &&fn)
+{
+    for (int attempt = 0;; ++attempt)
+    {
+        Session session = borrow(sqlText);
+        if (!session.connection)
+        {
+            return; // the server has already rolled back the transaction of the lost session
+        }
+
+        const bool inTransaction = session.inTransaction;
+        try
+        {
+            fn(*session.connection);
+        }
+        catch (const MySqlException &e)
+        {
+            const bool lost = MySqlConnection::isConnectionError(e);
+            giveBack(std::move(session), sqlText, lost);
+            if (lost && attempt == 0 && !inTransaction && canRetry(e))
+            {
+                continue;
+            }
+            throw;
+        }
+        catch (...)
+        {
+            giveBack(std::move(session), sqlText, false);
+            throw;
+        }
+
+        giveBack(std::move(session), sqlText, false);
+        return;
+    }
+}
+
+MySqlConnectionPool::Session MySqlConnectionPool::borrow(const std::string &sqlText)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    auto pinned = _pinned.find(std::this_thread::get_id());
+    if (pinned != _pinned.end())
+    {
+        if (pinned->second.connection)
+        {
+            Session session = std::move(pinned->second);
+            _pinned.erase(pinned);
+            return session;
+        }
+
+        // the transaction is lost with its session, only its end releases the thread
+        if (sqlText == _rollbackText)
+        {
+            _pinned.erase(pinned);
+            return Session();
+        }
+        if (sqlText == _commitText)
+        {
+            _pinned.erase(pinned);
+        }
+        throw MySqlException("The session of the transaction is lost", sqlText, CR_SERVER_LOST);
+    }
+
+    const auto deadline = Clock::now() + _options.borrowTimeout;
+    while (true)
+    {
+        while (!_idle.empty())
+        {
+            Session session = std::move(_idle.back()); // the most recently used session is the warmest one
+            _idle.pop_back();
+
+            const auto now = Clock::now();
+            const bool expiredSession = expired(session, now);
+            if (!expiredSession && now - session.lastUsed < _options.validationInterval)
+            {
+                return session;
+            }
+
+            lock.unlock();
+            if (!expiredSession && session.connection->ping())
+            {
+                return session;
+            }
+            session.connection.reset();
+            lock.lock();
+            --_open;
+            _wakeMaintenance.notify_one();
+        }
+
+        if (_open < _options.maxSessions)
+        {
+            ++_open;
+            lock.unlock();
+            try
+            {
+                return open();
+            }
+            catch (...)
+            {
+                lock.lock();
+                --_open;
+                _released.notify_one();
+                throw;
+            }
+        }
+
+        if (_released.wait_until(lock, deadline) == std::cv_status::timeout && _idle.empty() &&
+            _open >= _options.maxSessions)
+        {
+            throw MySqlException("Timed out waiting for a free session", sqlText);
+        }
+    }
+}
+
+void MySqlConnectionPool::giveBack(Session &&session, const std::string &sqlText, bool broken)
+{
+    Session retired; // closed after the lock is released
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const bool transactionEnds = sqlText == _commitText || sqlText == _rollbackText;
+    const bool wasInTransaction = session.inTransaction;
+    const bool inTransaction = (wasInTransaction || isBegin(sqlText)) && !transactionEnds;
+    const auto thread = std::this_thread::get_id();
+
+    if (broken)
+    {
+        retired = std::move(session);
+        --_open;
+        if (wasInTransaction && !transactionEnds)
+        {
+            _pinned[thread] = Session(); // remember the transaction is lost
+        }
+        _wakeMaintenance.notify_one();
+    }
+    else if (inTransaction)
+    {
+        session.inTransaction = true;
+        _pinned[thread] = std::move(session);
+        return;
+    }
+    else
+    {
+        session.inTransaction = false;
+        session.lastUsed = Clock::now();
+        if (expired(session, session.lastUsed))
+        {
+            retired = std::move(session);
+            --_open;
+            _wakeMaintenance.notify_one();
+        }
+        else
+        {
+            _idle.push_back(std::move(session));
+        }
+    }
+    _released.notify_one();
+}
+
+MySqlConnectionPool::Session MySqlConnectionPool::open() const
+{
+    Session session;
+    session.connection.reset(new MySqlConnection(_options.host, _options.port, _options.userName, _options.password,
+                                                 _options.database));
+    session.created = Clock::now();
+    session.lastUsed = session.created;
+    return session;
+}
+
+bool MySqlConnectionPool::expired(const Session &session, Clock::time_point now) const
+{
+    return now - session.created >= _options.maxLifetime;
+}
+
+void MySqlConnectionPool::maintain()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stopping)
+    {
+        _wakeMaintenance.wait_for(lock, _options.maintenanceInterval);
+        if (_stopping)
+        {
+            break;
+        }
+
+        // take out sessions to retire or validate, the rest stay available
+        const auto now = Clock::now();
+        std::vector<Session> retired;
+        std::vector<Session> stale;
+        for (auto iter = _idle.begin(); iter != _idle.end();)
+        {
+            if (expired(*iter, now))
+            {
+                retired.push_back(std::move(*iter));
+                --_open;
+            }
+            else if (now - iter->lastUsed >= _options.validationInterval)
+            {
+                stale.push_back(std::move(*iter));
+            }
+            else
+            {
+                ++iter;
+                continue;
+            }
+            iter = _idle.erase(iter);
+        }
+
+        lock.unlock();
+        retired.clear();
+        std::vector<Session> alive;
+        for (Session &session : stale)
+        {
+            if (session.connection->ping())
+            {
+                session.lastUsed = Clock::now();
+                alive.push_back(std::move(session));
+            }
+        }
+        const std::size_t dead = stale.size() - alive.size();
+        stale.clear();
+        lock.lock();
+
+        _open -= dead;
+        for (Session &session : alive)
+        {
+            _idle.push_back(std::move(session));
+            _released.notify_one();
+        }
+
+        // open standby sessions, a failure is retried on the next round
+        while (!_stopping && _open < _options.minSessions)
+        {
+            ++_open;
+            lock.unlock();
+            Session session;
+            try
+            {
+                session = open();
+            }
+            catch (const SqlException &)
+            {
+                lock.lock();
+                --_open;
+                break;
+            }
+            lock.lock();
+            _idle.push_back(std::move(session));
+            _released.notify_one();
+        }
+    }
+}
+
+} // namespace mysql
+} // namespace db
+} // namespace softeq
@@ -17,6 +17,23 @@ MySqlException::MySqlException(const std::string &message, const std::string &qu
 {
 }
 
+MySqlException::MySqlException(const std::string &message, const std::string &query, unsigned int errorCode)
+: SqlException(message + ": " + query)
+, _errorCode(errorCode)
+{
+}
+
+unsigned int MySqlException::errorCode() const
+{
+    return _errorCode;
+}
+
+bool MySqlException::retryable() const
+{
+    // ER_LOCK_WAIT_TIMEOUT and ER_LOCK_DEADLOCK, mysqld_error.h is not a part of the client headers everywhere
+    return _errorCode == 1205 || _errorCode == 1213;
+}
+
 } // namespace mysql
 } // namespace db
 } // namespace softeq
@@ -31,18 +31,53 @@ MySqlQueryStringBuilder::MySqlQueryStringBuilder(CellRepresentation &cellRepr)
 {
 }
 
-std::string adjustQueryTerminationCharacter(const std::string &query)
+namespace
 {
-    if (query.substr(query.length() - 1) == ",")
+std::string algorithmName(AlterQuery::Algorithm algorithm)
+{
+    switch (algorithm)
     {
-        std::string fixQuery = query;
-        fixQuery.pop_back();
-        fixQuery.push_back(';');
-        return fixQuery;
+    case AlterQuery::Algorithm::Instant:
+        return "INSTANT";
+    case AlterQuery::Algorithm::Inplace:
+        return "INPLACE";
+    case AlterQuery::Algorithm::Copy:
+        return "COPY";
+    default:
+        return "DEFAULT";
     }
+}
+
+std::string isolationName(TransactionOptions::Isolation isolation)
+{
+    switch (isolation)
+    {
+    case TransactionOptions::Isolation::ReadUncommitted:
+        return "READ UNCOMMITTED";
+    case TransactionOptions::Isolation::ReadCommitted:
+        return "READ COMMITTED";
+    case TransactionOptions::Isolation::RepeatableRead:
+        return "REPEATABLE READ";
+    default:
+        return "SERIALIZABLE";
+    }
+}
 
-    return query;
+std::string lockName(AlterQuery::Lock lock)
+{
+    switch (lock)
+    {
+    case AlterQuery::Lock::None:
+        return "NONE";
+    case AlterQuery::Lock::Shared:
+        return "SHARED";
+    case AlterQuery::Lock::Exclusive:
+        return "EXCLUSIVE";
+    default:
+        return "DEFAULT";
+    }
 }
+} // namespace
 
 std::vector<Statement> MySqlQueryStringBuilder::buildStatement(const class AlterQuery &query) const
 {
@@ -50,7 +85,9 @@ std::vector<Statement> MySqlQueryStringBuilder::buildStatement(const class Alter
 
     using namespace db;
 
+    // all actions go to a single statement, so InnoDB rebuilds the table at most once
     std::stringstream result;
+    std::string separator = " ";
 
     result << "ALTER TABLE " << query.table();
 
@@ -60,37 +97,79 @@ std::vector<Statement> MySqlQueryStringBuilder::buildStatement(const class Alter
         {
             continue;
         }
+        result << separator;
+        separator = ", ";
         // action types are essentially diffrent ALTER TABLE* commands
         switch (action.type)
         {
         case TableScheme::NO_OP:
             break;
         case TableScheme::RENAME_TABLE:
-            result << " RENAME TO " << action.table;
+            result << "RENAME TO " << action.table;
             break;
         case TableScheme::ADD_COLUMN:
-            result << " ADD " << cellRepr().fieldsWithDescr(cellRepr().columns({action.cell}));
+            result << "ADD " << cellRepr().fieldsWithDescr(cellRepr().columns({action.cell}));
             break;
         case TableScheme::DROP_COLUMN:
-            result << " DROP " << action.cell.unqualifiedName();
+            result << "DROP " << action.cell.unqualifiedName();
             break;
         case TableScheme::RENAME_COLUMN:
-            result << " RENAME COLUMN " << action.renameCell.first.unqualifiedName() << " TO "
+            result << "RENAME COLUMN " << action.renameCell.first.unqualifiedName() << " TO "
                    << action.renameCell.second.unqualifiedName();
             break;
         default:
             assert("Action types passed an element that does not have a handler in the case!");
             break;
         }
-        result << ",";
     }
 
-    return {adjustQueryTerminationCharacter(result.str())};
+    if (separator == " ")
+    {
+        return {}; // nothing to alter
+    }
+
+    // the server fails the statement if it can't apply it the requested way, there is no silent table copy
+    if (query.algorithm() == AlterQuery::Algorithm::Instant && query.lock() != AlterQuery::Lock::Default)
+    {
+        throw MySqlException("ALGORITHM=INSTANT does not accept a LOCK clause");
+    }
+    if (query.algorithm() != AlterQuery::Algorithm::Default)
+    {
+        result << ", ALGORITHM=" << algorithmName(query.algorithm());
+    }
+    if (query.lock() != AlterQuery::Lock::Default)
+    {
+        result << ", LOCK=" << lockName(query.lock());
+    }
+    result << ";";
+
+    return {result.str()};
+}
+
+std::vector<Statement> MySqlQueryStringBuilder::buildStatement(const class BeginTransactionQuery &query) const
+{
+    std::vector<Statement> statements;
+
+    // SET TRANSACTION applies to the next transaction of the session only
+    const TransactionOptions &options = query.options();
+    if (options.isolation != TransactionOptions::Isolation::Default)
+    {
+        statements.emplace_back("SET TRANSACTION ISOLATION LEVEL " + isolationName(options.isolation) + "; ");
+    }
+    statements.emplace_back(options.readOnly ? "START TRANSACTION READ ONLY; " : "START TRANSACTION; ");
+
+    return statements;
 }
 
-std::vector<Statement> MySqlQueryStringBuilder::buildStatement(const class BeginTransactionQuery &) const
+std::vector<Token> MySqlQueryStringBuilder::valueList(const Token &list) const
 {
-    return {Statement("START TRANSACTION; ")};
+    // JSON_TABLE needs a column type, it decides whether the values are compared as numbers or as strings
+    const std::string type = list.listType() == SqlValue::Subtype::Integer ? "BIGINT" : "TEXT";
+
+    std::vector<Token> tokens;
+    tokens << "SELECT value FROM JSON_TABLE(" << list.value() << ", '$[*]' COLUMNS (value " << type
+           << " PATH '$')) AS list_values";
+    return tokens;
 }
 
 std::string MySqlCellRepresentation::typeToCastType(const std::string &typeName) const
@@ -0,0 +1,305 @@
+#include "onlineschemachange.hh"
+
+#include <map>
+#include <set>
+#include <thread>
+
+namespace softeq
+{
+namespace db
+{
+namespace mysql
+{
+namespace
+{
+/*!
+    \brief A query made of ready statement tokens
+*/
+class RawQuery : public SqlQuery
+{
+public:
+    explicit RawQuery(std::vector<Token> &&tokens)
+        : SqlQuery(TableScheme())
+        , _statement(std::move(tokens))
+    {
+    }
+
+    std::vector<Statement> buildStatement(const SqlQueryStringBuilder &) const override
+    {
+        return {_statement};
+    }
+
+private:
+    Statement _statement;
+};
+
+std::string join(const std::vector<std::string> &items, const std::string &prefix = "")
+{
+    std::string result;
+    for (const std::string &item : items)
+    {
+        result += (result.empty() ? "" : ", ") + prefix + item;
+    }
+    return result;
+}
+} // namespace
+
+OnlineSchemaChange::OnlineSchemaChange(const Connection::SPtr &connection, const AlterQuery &alter,
+                                       const Options &options)
+    : _connection(connection)
+    , _alter(alter)
+    , _options(options)
+    , _table(alter.table())
+    , _shadowTable("_" + alter.table() + "_new")
+    , _oldTable("_" + alter.table() + "_old")
+{
+    if (_options.chunkSize == 0)
+    {
+        throw SqlException("Chunk size must not be zero");
+    }
+
+    std::set<std::string> dropped;
+    std::map<std::string, std::string> renamed;
+    for (const auto &action : alter.alters())
+    {
+        switch (action.type)
+        {
+        case TableScheme::RENAME_TABLE:
+            throw SqlException("Table '" + _table + "' can't be renamed by an online change");
+        case TableScheme::DROP_COLUMN:
+            dropped.insert(action.cell.unqualifiedName());
+            break;
+        case TableScheme::RENAME_COLUMN:
+            renamed[action.renameCell.first.unqualifiedName()] = action.renameCell.second.unqualifiedName();
+            break;
+        default:
+            break;
+        }
+    }
+
+    // columns kept by the alteration are copied, added ones get their defaults
+    std::size_t keys = 0;
+    for (const Cell &cell : alter.scheme().cells())
+    {
+        const std::string name = cell.unqualifiedName();
+        const bool primaryKey = cell.flags() & Cell::PRIMARY_KEY;
+        if (dropped.count(name))
+        {
+            if (primaryKey)
+            {
+                throw SqlException("Primary key of '" + _table + "' can't be dropped by an online change");
+            }
+            continue;
+        }
+
+        auto rename = renamed.find(name);
+        _sourceColumns.push_back(name);
+        _targetColumns.push_back(rename == renamed.end() ? name : rename->second);
+        if (primaryKey)
+        {
+            _sourceKey = _sourceColumns.back();
+            _targetKey = _targetColumns.back();
+            ++keys;
+        }
+    }
+    if (keys != 1)
+    {
+        throw SqlException("Online change of '" + _table + "' requires a single column primary key");
+    }
+}
+
+void OnlineSchemaChange::run()
+{
+    checkForeignKeys();
+    try
+    {
+        createShadow();
+        createTriggers();
+        copyRows();
+    }
+    catch (...)
+    {
+        cleanUp();
+        throw;
+    }
+    swap();
+}
+
+void OnlineSchemaChange::execute(std::vector<Token> &&tokens)
+{
+    _connection->perform(RawQuery(std::move(tokens)));
+}
+
+std::vector<std::string> OnlineSchemaChange::fetchColumn(std::vector<Token> &&tokens)
+{
+    std::vector<std::string> values;
+    _connection->perform(RawQuery(std::move(tokens)),
+                         [&values](const std::map<std::string, int> &, const std::vector<const char *> &row) {
+                             values.emplace_back(row[0] ? row[0] : "");
+                         });
+    return values;
+}
+
+void OnlineSchemaChange::checkForeignKeys()
+{
+    // CREATE TABLE ... LIKE doesn't copy foreign keys, and the ones referencing the table follow it to the old name
+    // on RENAME TABLE, so either way the swapped table would silently lose them
+    std::vector<Token> sql;
+    sql << "SELECT CONCAT(TABLE_NAME, '.', CONSTRAINT_NAME) FROM information_schema.REFERENTIAL_CONSTRAINTS "
+           "WHERE CONSTRAINT_SCHEMA = DATABASE() AND (TABLE_NAME = "
+        << SqlValue(std::string(_table)) << " OR REFERENCED_TABLE_NAME = " << SqlValue(std::string(_table)) << ");";
+    auto constraints = fetchColumn(std::move(sql));
+    if (!constraints.empty())
+    {
+        throw SqlException("Online change of '" + _table + "' is not possible, it has foreign keys: " +
+                           join(constraints));
+    }
+}
+
+void OnlineSchemaChange::createShadow()
+{
+    std::vector<Token> sql;
+    sql << "CREATE TABLE " << _shadowTable << " LIKE " << _table << ";";
+    execute(std::move(sql));
+
+    // the table is empty, so the alteration is cheap whatever algorithm the server picks
+    _connection->perform(_alter.forTable(_shadowTable).online(AlterQuery::Algorithm::Default));
+}
+
+void OnlineSchemaChange::createTriggers()
+{
+    const std::string replaceRow = "REPLACE INTO " + _shadowTable + " (" + join(_targetColumns) + ") VALUES (" +
+                                   join(_sourceColumns, "NEW.") + ")";
+    const std::string deleteRow =
+        "DELETE IGNORE FROM " + _shadowTable + " WHERE " + _targetKey + " = OLD." + _sourceKey;
+
+    // trigger definitions can't be prepared, so they are run as text and must not end with ';'
+    std::vector<Token> sql;
+    sql << "CREATE TRIGGER _" + _table + "_osc_ins AFTER INSERT ON " + _table + " FOR EACH ROW " + replaceRow;
+    execute(std::move(sql));
+
+    sql.clear();
+    sql << "CREATE TRIGGER _" + _table + "_osc_upd AFTER UPDATE ON " + _table + " FOR EACH ROW BEGIN " + deleteRow +
+               "; " + replaceRow + "; END";
+    execute(std::move(sql));
+
+    sql.clear();
+    sql << "CREATE TRIGGER _" + _table + "_osc_del AFTER DELETE ON " + _table + " FOR EACH ROW " + deleteRow;
+    execute(std::move(sql));
+}
+
+void OnlineSchemaChange::copyRows()
+{
+    Progress progress;
+
+    std::vector<Token> sql;
+    sql << "SELECT TABLE_ROWS FROM information_schema.TABLES WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = "
+        << SqlValue(std::string(_table)) << ";";
+    auto estimate = fetchColumn(std::move(sql));
+    if (!estimate.empty())
+    {
+        progress.estimatedRows = std::strtoull(estimate.front().c_str(), nullptr, 10);
+    }
+
+    // chunks are (lower, upper] ranges of the primary key, the first one has no lower bound
+    bool first = true;
+    std::string lower;
+    while (true)
+    {
+        const auto started = std::chrono::steady_clock::now();
+
+        sql.clear();
+        sql << "SELECT " << _sourceKey << " FROM " << _table;
+        if (!first)
+        {
+            sql << " WHERE " << _sourceKey << " > " << SqlValue(std::string(lower));
+        }
+        sql << " ORDER BY " << _sourceKey << " LIMIT " << std::to_string(_options.chunkSize) << ";";
+        auto keys = fetchColumn(std::move(sql));
+        if (keys.empty())
+        {
+            break;
+        }
+
+        // rows already replayed by the triggers are newer, so they are kept
+        sql.clear();
+        sql << "INSERT IGNORE INTO " << _shadowTable << " (" << join(_targetColumns) << ") SELECT "
+            << join(_sourceColumns) << " FROM " << _table << " WHERE ";
+        if (!first)
+        {
+            sql << _sourceKey << " > " << SqlValue(std::string(lower)) << " AND ";
+        }
+        sql << _sourceKey << " <= " << SqlValue(std::string(keys.back())) << " LOCK IN SHARE MODE;";
+        execute(std::move(sql));
+
+        progress.copiedRows += keys.size();
+        ++progress.chunks;
+        progress.lastChunk =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+        if (_options.onProgress)
+        {
+            _options.onProgress(progress);
+        }
+
+        if (keys.size() < _options.chunkSize)
+        {
+            break;
+        }
+        first = false;
+        lower = keys.back();
+
+        if (_options.throttle)
+        {
+            std::this_thread::sleep_for(_options.throttle(progress));
+        }
+    }
+}
+
+void OnlineSchemaChange::swap()
+{
+    std::vector<Token> sql;
+    sql << "RENAME TABLE " << _table << " TO " << _oldTable << ", " << _shadowTable << " TO " << _table << ";";
+    execute(std::move(sql));
+
+    for (const char *suffix : {"_osc_ins", "_osc_upd", "_osc_del"})
+    {
+        sql.clear();
+        sql << "DROP TRIGGER IF EXISTS _" + _table + suffix + ";";
+        execute(std::move(sql));
+    }
+
+    if (!_options.keepOldTable)
+    {
+        sql.clear();
+        sql << "DROP TABLE " << _oldTable << ";";
+        execute(std::move(sql));
+    }
+}
+
+void OnlineSchemaChange::cleanUp()
+{
+    std::vector<std::string> statements;
+    for (const char *suffix : {"_osc_ins", "_osc_upd", "_osc_del"})
+    {
+        statements.push_back("DROP TRIGGER IF EXISTS _" + _table + suffix + ";");
+    }
+    statements.push_back("DROP TABLE IF EXISTS " + _shadowTable + ";");
+
+    for (const std::string &statement : statements)
+    {
+        try
+        {
+            std::vector<Token> sql;
+            sql << statement;
+            execute(std::move(sql));
+        }
+        catch (const SqlException &)
+        {
+            // the original error is more important
+        }
+    }
+}
+
+} // namespace mysql
+} // namespace db
+} // namespace softeq
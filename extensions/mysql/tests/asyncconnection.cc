@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <dbfacade/insert.hh>
+#include <dbfacade/select.hh>
+#include <dbfacade/createtable.hh>
+#include <dbfacade/drop.hh>
+#include <mysql/mysqlasyncconnection.hh>
+
+#include <poll.h>
+
+using namespace softeq;
+
+namespace
+{
+struct AsyncRecord
+{
+    int id;
+    std::string name;
+};
+
+/*!
+    \brief Runs an event loop until all connections are done
+*/
+void runLoop(const std::vector<db::mysql::MySqlAsyncConnection *> &connections)
+{
+    while (true)
+    {
+        std::vector<pollfd> fds;
+        for (auto connection : connections)
+        {
+            if (!connection->step())
+            {
+                fds.push_back({connection->socket(), POLLIN | POLLOUT, 0});
+            }
+        }
+        if (fds.empty())
+        {
+            return;
+        }
+        ASSERT_GE(poll(fds.data(), fds.size(), 1000), 0);
+    }
+}
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<AsyncRecord>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("async_record",
+        {
+            {&AsyncRecord::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&AsyncRecord::name, "name"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST(MySqlAsyncConnection, SeveralSessionsOneLoop)
+{
+    namespace sql = db::query;
+
+    db::mysql::MySqlAsyncConnection writer("127.0.0.1", 3306, "user", "secret", "db");
+    db::mysql::MySqlAsyncConnection reader("127.0.0.1", 3306, "user", "secret", "db");
+
+    int completed = 0;
+    auto expectSuccess = [&completed](std::exception_ptr error) {
+        EXPECT_FALSE(error);
+        ++completed;
+    };
+
+    writer.submit(sql::createTable<AsyncRecord>(), nullptr, expectSuccess);
+    writer.submit(sql::insert<AsyncRecord>({1, "O'Brien"}), nullptr, expectSuccess);
+    writer.submit(sql::insert<AsyncRecord>({2, "Smith"}), nullptr, expectSuccess);
+    reader.submit(sql::select<AsyncRecord>({}), nullptr, [&completed](std::exception_ptr) { ++completed; });
+    runLoop({&writer, &reader});
+    EXPECT_EQ(completed, 4);
+
+    std::vector<std::string> names;
+    reader.submit(
+        sql::select<AsyncRecord>({}).orderBy(&AsyncRecord::id),
+        [&names](const std::map<std::string, int> &header, const std::vector<const char *> &row) {
+            names.emplace_back(row[header.at("name")]);
+        },
+        expectSuccess);
+
+    // errors are reported to the completion, the session is still usable
+    std::exception_ptr failure;
+    writer.submit(sql::insert<AsyncRecord>({1, "Duplicate"}), nullptr,
+                  [&failure](std::exception_ptr error) { failure = error; });
+    writer.submit(sql::drop<AsyncRecord>(), nullptr, expectSuccess);
+
+    runLoop({&writer, &reader});
+    EXPECT_TRUE(failure);
+    EXPECT_EQ(names, std::vector<std::string>({"O'Brien", "Smith"}));
+    EXPECT_FALSE(writer.busy());
+}
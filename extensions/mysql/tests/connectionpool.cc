@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <dbfacade/facade.hh>
+#include <mysql/mysqlconnectionpool.hh>
+
+#include <atomic>
+#include <thread>
+
+using namespace softeq;
+
+namespace
+{
+/*!
+    \brief A query with a fixed text, enough to reach the session itself
+*/
+class PlainQuery : public db::SqlQuery
+{
+public:
+    explicit PlainQuery(const std::string &text)
+        : db::SqlQuery(db::TableScheme())
+        , _text(text)
+    {
+    }
+
+    std::vector<db::Statement> buildStatement(const db::SqlQueryStringBuilder &) const override
+    {
+        return {db::Statement(_text)};
+    }
+
+private:
+    std::string _text;
+};
+
+db::mysql::MySqlConnectionPool::Options poolOptions()
+{
+    db::mysql::MySqlConnectionPool::Options options;
+    options.userName = "user";
+    options.password = "secret";
+    options.database = "db";
+    options.minSessions = 2;
+    options.maxSessions = 4;
+    options.validationInterval = std::chrono::milliseconds(0); // always validate
+    return options;
+}
+
+std::string connectionId(db::Connection &connection)
+{
+    std::string id;
+    connection.perform(PlainQuery("SELECT CONNECTION_ID() AS id;"),
+                       [&id](const std::map<std::string, int> &, const std::vector<const char *> &row) {
+                           id = row[0];
+                       });
+    return id;
+}
+} // namespace
+
+TEST(MySqlConnectionPool, WarmSessions)
+{
+    db::mysql::MySqlConnectionPool pool(poolOptions());
+    EXPECT_EQ(pool.openSessions(), 2);
+    EXPECT_EQ(pool.idleSessions(), 2);
+
+    std::atomic<int> done(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i)
+    {
+        threads.emplace_back([&pool, &done]() {
+            for (int j = 0; j < 10; ++j)
+            {
+                EXPECT_FALSE(connectionId(pool).empty());
+            }
+            ++done;
+        });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(done, 8);
+    EXPECT_LE(pool.openSessions(), 4);
+}
+
+TEST(MySqlConnectionPool, ReconnectAfterKill)
+{
+    db::mysql::MySqlConnectionPool pool(poolOptions());
+    db::mysql::MySqlConnection admin("127.0.0.1", 3306, "user", "secret", "db");
+
+    // the most recently used session is borrowed again, kill it on the server
+    std::string id = connectionId(pool);
+    admin.perform(PlainQuery("KILL " + id + ";"));
+
+    std::string newId;
+    ASSERT_NO_THROW(newId = connectionId(pool));
+    EXPECT_NE(newId, id);
+}
+
+TEST(MySqlConnectionPool, TransactionKeepsSession)
+{
+    db::mysql::MySqlConnectionPool::Options options = poolOptions();
+    auto pool = std::make_shared<db::mysql::MySqlConnectionPool>(options);
+    db::Facade storage(pool);
+
+    std::string first;
+    std::string last;
+    storage.execTransaction([&](db::Facade &) {
+        first = connectionId(*pool);
+        // another thread can't get the session of the transaction
+        std::thread([&pool, &first]() { EXPECT_NE(connectionId(*pool), first); }).join();
+        last = connectionId(*pool);
+        return true;
+    });
+    EXPECT_EQ(first, last);
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <dbfacade/facade.hh>
+#include <dbfacade/constraints.hh>
+#include <dbfacade/createtable.hh>
+#include <dbfacade/drop.hh>
+#include <dbfacade/insert.hh>
+#include <dbfacade/select.hh>
+#include <mysql/mysqlconnection.hh>
+#include <mysql/onlineschemachange.hh>
+
+using namespace softeq;
+
+namespace
+{
+struct OscOld
+{
+    int id;
+    std::string name;
+    int obsolete;
+};
+
+struct OscNew
+{
+    int id;
+    std::string fullName;
+    int grade;
+};
+
+struct OscGrade
+{
+    int id;
+    int studentId;
+};
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<OscOld>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("osc_student",
+        {
+            {&OscOld::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&OscOld::name, "name"},
+            {&OscOld::obsolete, "obsolete"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+template <>
+const db::TableScheme db::buildTableScheme<OscNew>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("osc_student",
+        {
+            {&OscNew::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&OscNew::fullName, "full_name"},
+            {&OscNew::grade, "grade", db::Cell::Flags::DEFAULT, 50}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+template <>
+const db::TableScheme db::buildTableScheme<OscGrade>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("osc_grade",
+        {
+            {&OscGrade::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&OscGrade::studentId, "student_id"}
+        },
+        {
+            db::constraints::makeConstraint<db::constraints::ForeignKeyConstraint>(&OscGrade::studentId, &OscOld::id)
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST(MySqlOnlineSchemaChange, ChunkedCopyAndSwap)
+{
+    namespace sql = db::query;
+
+    db::Connection::SPtr connection(new db::mysql::MySqlConnection("127.0.0.1", 3306, "user", "secret", "db"));
+    db::Facade storage(connection);
+    storage.execute(sql::createTable<OscOld>());
+
+    std::vector<OscOld> rows;
+    for (int id = 1; id <= 250; ++id)
+    {
+        rows.push_back({id, "name" + std::to_string(id), id});
+    }
+    storage.execute(sql::insert(rows));
+
+    db::mysql::OnlineSchemaChange::Options options;
+    options.chunkSize = 100;
+    std::vector<std::uint64_t> copied;
+    options.onProgress = [&](const db::mysql::OnlineSchemaChange::Progress &progress) {
+        copied.push_back(progress.copiedRows);
+        if (progress.chunks == 1)
+        {
+            // a concurrent change is replayed by the triggers
+            storage.execute(sql::insert<OscOld>({1000, "late", 0}));
+        }
+    };
+    options.throttle = [](const db::mysql::OnlineSchemaChange::Progress &) { return std::chrono::milliseconds(1); };
+
+    auto change = db::mysql::query::onlineAlterScheme<OscOld, OscNew>(connection, options,
+                                                                      {{&OscOld::name, &OscNew::fullName}});
+    change.run();
+
+    EXPECT_EQ(copied, std::vector<std::uint64_t>({100, 200, 251}));
+
+    std::vector<OscNew> data = storage.receive(sql::select<OscNew>({}).orderBy(&OscNew::id));
+    ASSERT_EQ(data.size(), 251);
+    EXPECT_EQ(data.front().fullName, "name1");
+    EXPECT_EQ(data.front().grade, 50);
+    EXPECT_EQ(data.back().id, 1000);
+    EXPECT_EQ(data.back().fullName, "late");
+
+    storage.execute(sql::drop<OscNew>());
+}
+
+TEST(MySqlOnlineSchemaChange, ForeignKeysRefused)
+{
+    namespace sql = db::query;
+
+    db::Connection::SPtr connection(new db::mysql::MySqlConnection("127.0.0.1", 3306, "user", "secret", "db"));
+    db::Facade storage(connection);
+    storage.execute(sql::createTable<OscOld>());
+    storage.execute(sql::createTable<OscGrade>());
+
+    // both the referenced and the referencing table would lose the constraint
+    auto referenced = db::mysql::query::onlineAlterScheme<OscOld, OscNew>(connection);
+    EXPECT_THROW(referenced.run(), db::SqlException);
+    auto referencing = db::mysql::OnlineSchemaChange(
+        connection, db::query::alterScheme<OscGrade, OscGrade>(), db::mysql::OnlineSchemaChange::Options());
+    EXPECT_THROW(referencing.run(), db::SqlException);
+
+    // nothing was touched
+    EXPECT_NO_THROW(storage.execute(sql::insert<OscOld>({1, "name", 0})));
+    EXPECT_NO_THROW(storage.execute(sql::insert<OscGrade>({1, 1})));
+
+    storage.execute(sql::drop<OscGrade>());
+    storage.execute(sql::drop<OscOld>());
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <dbfacade/alter.hh>
+#include <dbfacade/select.hh>
+#include <mysql/mysqlexception.hh>
+#include <mysql/mysqlquerybuilder.hh>
+
+using namespace softeq;
+
+namespace
+{
+struct BuilderOld
+{
+    int id;
+    std::string name;
+    int obsolete;
+};
+
+struct BuilderNew
+{
+    int id;
+    std::string fullName;
+    int grade;
+    int rank;
+};
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<BuilderOld>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("builder_student",
+        {
+            {&BuilderOld::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&BuilderOld::name, "name"},
+            {&BuilderOld::obsolete, "obsolete"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+template <>
+const db::TableScheme db::buildTableScheme<BuilderNew>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("builder_student",
+        {
+            {&BuilderNew::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&BuilderNew::fullName, "full_name"},
+            {&BuilderNew::grade, "grade", db::Cell::Flags::DEFAULT, 50},
+            {&BuilderNew::rank, "rank", db::Cell::Flags::DEFAULT, 0}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST(MySqlQueryBuilder, AlterSingleStatement)
+{
+    db::mysql::MySqlCellRepresentation cellRepr;
+    db::mysql::MySqlQueryStringBuilder builder(cellRepr);
+
+    auto alter = db::query::alterScheme<BuilderOld, BuilderNew>().renamingCell(&BuilderOld::name,
+                                                                                 &BuilderNew::fullName);
+    auto statements = alter.buildStatement(builder);
+    ASSERT_EQ(statements.size(), 1);
+
+    std::string sql = statements.front().compose();
+    EXPECT_EQ(sql.compare(0, 28, "ALTER TABLE builder_student "), 0) << sql;
+    EXPECT_NE(sql.find("RENAME COLUMN name TO full_name"), std::string::npos) << sql;
+    EXPECT_NE(sql.find("DROP obsolete"), std::string::npos) << sql;
+    EXPECT_NE(sql.find("ADD grade"), std::string::npos) << sql;
+    EXPECT_NE(sql.find("ADD rank"), std::string::npos) << sql;
+    EXPECT_EQ(sql.find("ALTER TABLE", 1), std::string::npos) << sql;
+    EXPECT_EQ(sql.back(), ';');
+
+    alter.online(db::AlterQuery::Algorithm::Inplace, db::AlterQuery::Lock::None);
+    sql = alter.buildStatement(builder).front().compose();
+    EXPECT_NE(sql.find(", ALGORITHM=INPLACE, LOCK=NONE;"), std::string::npos) << sql;
+
+    alter.online(db::AlterQuery::Algorithm::Instant, db::AlterQuery::Lock::None);
+    EXPECT_THROW(alter.buildStatement(builder), db::mysql::MySqlException);
+
+    // nothing to alter
+    auto unchanged = db::query::alterScheme<BuilderOld, BuilderOld>();
+    EXPECT_TRUE(unchanged.buildStatement(builder).empty());
+}
+
+TEST(MySqlQueryBuilder, BeginTransaction)
+{
+    db::mysql::MySqlCellRepresentation cellRepr;
+    db::mysql::MySqlQueryStringBuilder builder(cellRepr);
+
+    auto statements = db::query::beginTransaction().buildStatement(builder);
+    ASSERT_EQ(statements.size(), 1);
+    EXPECT_EQ(statements.front().compose(), "START TRANSACTION; ");
+
+    auto options = db::TransactionOptions::readOnlyWith(db::TransactionOptions::Isolation::ReadCommitted);
+    statements = db::query::beginTransaction(options).buildStatement(builder);
+    ASSERT_EQ(statements.size(), 2);
+    EXPECT_EQ(statements[0].compose(), "SET TRANSACTION ISOLATION LEVEL READ COMMITTED; ");
+    EXPECT_EQ(statements[1].compose(), "START TRANSACTION READ ONLY; ");
+
+    statements = db::query::savepoint("sp_1").buildStatement(builder);
+    ASSERT_EQ(statements.size(), 1);
+    EXPECT_EQ(statements.front().compose(), "SAVEPOINT sp_1;");
+}
+
+TEST(MySqlQueryBuilder, InValues)
+{
+    db::mysql::MySqlCellRepresentation cellRepr;
+    db::mysql::MySqlQueryStringBuilder builder(cellRepr);
+
+    auto ids = db::query::select<BuilderOld>({&BuilderOld::name})
+                   .where(db::field(&BuilderOld::id).inValues(std::vector<int>{1, 2, 3}));
+    auto statements = ids.buildStatement(builder);
+    ASSERT_EQ(statements.size(), 1);
+    EXPECT_EQ(statements.front().compose(),
+              "SELECT builder_student.name FROM builder_student WHERE (builder_student.id IN (SELECT value FROM "
+              "JSON_TABLE(?, '$[*]' COLUMNS (value BIGINT PATH '$')) AS list_values));");
+    ASSERT_EQ(statements.front().parameters().size(), 1);
+    EXPECT_EQ(statements.front().parameters().front().toString(), "[1,2,3]");
+
+    auto names = db::query::select<BuilderOld>({&BuilderOld::id})
+                     .where(db::field(&BuilderOld::name).inValues(std::vector<std::string>{"a\"b"}));
+    statements = names.buildStatement(builder);
+    EXPECT_NE(statements.front().compose().find("COLUMNS (value TEXT PATH '$')"), std::string::npos);
+    EXPECT_EQ(statements.front().parameters().front().toString(), "[\"a\\\"b\"]");
+}
@@ -13,6 +13,28 @@ namespace db
 class AlterQuery : public SerializableSqlQuery<AlterQuery>
 {
 public:
+    /*!
+        \brief The way the database applies the alteration (MySQL ALGORITHM clause)
+    */
+    enum class Algorithm
+    {
+        Default,
+        Instant, //! metadata only, the table is not touched
+        Inplace, //! no table copy, may rebuild in place
+        Copy
+    };
+
+    /*!
+        \brief Concurrent access allowed during the alteration (MySQL LOCK clause)
+    */
+    enum class Lock
+    {
+        Default,
+        None, //! reads and writes are allowed
+        Shared,
+        Exclusive
+    };
+
     explicit AlterQuery(const softeq::db::TableScheme &scheme);
 
     /*!
@@ -30,6 +52,27 @@ public:
     */
     const TableScheme::DiffActionItems &alters() const;
 
+    /*!
+        \brief Requests the way the alteration is applied. The database fails the query instead of falling back
+        to a more expensive way (e.g. a table copy) if it can't satisfy the request.
+        Databases without such a choice (e.g. Sqlite) ignore it.
+        \param algorithm requested algorithm
+        \param lock requested lock level
+        \return this AlterQuery object
+    */
+    AlterQuery &online(Algorithm algorithm, Lock lock = Lock::Default);
+
+    Algorithm algorithm() const;
+    Lock lock() const;
+
+    /*!
+        \brief Makes a copy of the query that applies the same alterations to another table with the same columns
+        (e.g. a shadow copy of the table)
+        \param table name of the other table
+        \return the query
+    */
+    AlterQuery forTable(const std::string &table) const;
+
     /*!
         \brief The method specifies that difference between two schemes must be calculated automatically.
         Note that there is no way to automatically find out that a column must be renamed, such alterations
@@ -45,6 +88,8 @@ public:
 
 private:
     TableScheme::DiffActionItems _alters;
+    Algorithm _algorithm = Algorithm::Default;
+    Lock _lock = Lock::Default;
 };
 
 namespace query
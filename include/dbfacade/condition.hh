@@ -83,6 +83,41 @@ class Condition
 {
     std::vector<Token> _tokens;
 
+    static void appendJson(std::string &json, const SqlValue &value)
+    {
+        if (value.type() == SqlValue::Subtype::Integer)
+        {
+            json += std::to_string(value.intValue());
+            return;
+        }
+        if (value.type() == SqlValue::Subtype::Null)
+        {
+            json += "null";
+            return;
+        }
+        json += '"';
+        for (char c : value.toString())
+        {
+            if (c == '"' || c == '\\')
+            {
+                json += '\\';
+                json += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                static const char digits[] = "0123456789abcdef";
+                json += "\\u00";
+                json += digits[(c >> 4) & 0xf];
+                json += digits[c & 0xf];
+            }
+            else
+            {
+                json += c;
+            }
+        }
+        json += '"';
+    }
+
 public:
     struct WithoutParenthesis
     {
@@ -254,6 +289,36 @@ public:
     {
         return Condition{Operator::IN, *this, Condition{list}};
     }
+    /*!
+        \brief Builds 'expression IN (list)' with the whole list bound as one parameter (a JSON array), so the
+        statement text does not depend on the number of values and no parameter limit is hit.
+        The list is read by json_each on Sqlite and by JSON_TABLE on MySQL (8.0.4 and newer).
+        \param values a container of integers or strings
+     */
+    template <typename Container>
+    Condition inValues(const Container &values) const
+    {
+        std::string json = "[";
+        SqlValue::Subtype elementType = SqlValue::Subtype::Integer;
+        for (const auto &element : values)
+        {
+            const SqlValue value = Condition(element)._tokens.front().value();
+            if (json.size() > 1)
+            {
+                json += ",";
+            }
+            appendJson(json, value);
+            if (value.type() != SqlValue::Subtype::Integer && value.type() != SqlValue::Subtype::Null)
+            {
+                elementType = SqlValue::Subtype::String;
+            }
+        }
+        json += "]";
+
+        Condition list;
+        list._tokens << "(" << Token::list(SqlValue(std::move(json)), elementType) << ")";
+        return Condition{Operator::IN, *this, list};
+    }
     template <typename Low, typename High>
     Condition between(Low low, High high) const
     {
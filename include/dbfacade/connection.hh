@@ -1,14 +1,22 @@
 #ifndef SOFTEQ_DBFACADE_CONNECTION_H_
 #define SOFTEQ_DBFACADE_CONNECTION_H_
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <map>
+#include <mutex>
 #include <vector>
 #include <string>
+#include <thread>
 
 #include "sqlquery.hh"
 #include "sqlquerybuilder.hh"
 #include "sqlexception.hh"
+#include "connectionobserver.hh"
+#include "queryplan.hh"
+#include "resultcache.hh"
+#include "entitycache.hh"
 
 namespace softeq
 {
@@ -34,15 +42,265 @@ public:
 
     void perform(const SqlQuery &query, const parseFunc &pf = nullptr)
     {
-        performImpl(query.buildStatement(queryBuilder()), pf);
+        auto lease = this->lease();
+        const std::vector<Statement> statements = query.buildStatement(queryBuilder());
+        if (statements.size() > 1)
+        {
+            performSplit(query, statements, pf);
+        }
+        else
+        {
+            performStatements(query, statements, pf);
+        }
     }
 
-    virtual void verifyScheme(const TableScheme &) = 0;
+    /*!
+        \brief Attaches a cache of SELECT results. Changes made through the connection invalidate it.
+        \param cache the cache, nullptr to detach
+    */
+    void setResultCache(const ResultCache::SPtr &cache);
+
+    /*!
+        \brief Attaches a cache of rows looked up by Facade::find. Changes made through the connection
+        invalidate it.
+        \param cache the cache, nullptr to detach
+    */
+    void setEntityCache(const EntityCache::SPtr &cache);
+
+    /*!
+        \return the attached entity cache or nullptr
+    */
+    EntityCache::SPtr entityCache() const;
+
+    /*!
+        \brief Verifies that an actual table matches the scheme
+        \param scheme the scheme
+        \throw SchemeException if it does not
+    */
+    void verifyScheme(const TableScheme &scheme)
+    {
+        verifySchemes({scheme});
+    }
+
+    /*!
+        \brief Verifies that actual tables match their schemes. Catalog data of all tables is fetched
+        by a single query.
+        \param schemes the schemes
+        \throw SchemeException with all mismatches found
+    */
+    void verifySchemes(const std::vector<TableScheme> &schemes);
+
+    /*!
+        \brief Asks the database how it is going to execute a query (e.g. EXPLAIN QUERY PLAN)
+        \param query the query to explain
+        \return the execution plan of all statements of the query
+    */
+    QueryPlan explain(const SqlQuery &query);
+
+    /*!
+        \brief Asks the database how it is going to execute a statement.
+        The statement itself is not executed, observers are not notified.
+        \param sql statement text with placeholders
+        \param parameters values to bind
+        \return the execution plan
+    */
+    virtual QueryPlan explainStatement(const std::string &sql, const std::vector<SqlValue> &parameters) = 0;
+
+    /*!
+        \brief Attaches an observer that will be notified about every statement performed on the connection.
+        \param observer the observer
+    */
+    void addObserver(const ConnectionObserver::SPtr &observer);
+
+    /*!
+        \brief Detaches an observer
+        \param observer the observer previously attached by addObserver
+    */
+    void removeObserver(const ConnectionObserver::SPtr &observer);
+
+    /*!
+        \brief The number of transactions the calling thread has started by Facade::execTransaction on the
+        connection and not finished yet. Nested transactions are savepoints of the outermost one.
+        \return 0 outside a transaction
+    */
+    std::size_t transactionDepth() const;
+
+    /*!
+        \brief The number of rows inserted, updated or removed by the last query the calling thread performed on
+        the connection. Rows changed by triggers and foreign key actions are not counted.
+        \return 0 if the last query changed no rows or was not a data change
+    */
+    std::uint64_t changedRows() const;
+
+    /*!
+        \brief Reserves the session for the calling thread. Statements of other threads wait until the lock is
+        released, the calling thread may lease the session again. Transactions hold the lease while they last.
+        \return the lock, it may be empty if the connection gives every thread its own session (e.g. a pool)
+    */
+    virtual std::unique_lock<std::recursive_mutex> lease();
 
 protected:
+    /*!
+        \brief Column description read from the database catalog
+    */
+    struct ColumnInfo
+    {
+        std::string table;
+        std::string name;
+        std::string type;
+        std::string defaultValue;
+        bool nullable = false;
+        bool primaryKey = false;
+    };
+
+    /*!
+        \brief Reads descriptions of columns of the tables in one query
+        \param tables table names
+        \return columns of existing tables, the columns of a table go in their order in the table
+    */
+    virtual std::vector<ColumnInfo> describeTables(const std::vector<std::string> &tables) = 0;
+
+    /*!
+        \brief Compares a column type reported by the database with the type expected by the scheme
+        \param actual the type reported by the database
+        \param expected the type produced by the cell representation
+        \return true if types match
+    */
+    virtual bool sameType(const std::string &actual, const std::string &expected) const
+    {
+        return actual == expected;
+    }
+
+    /*!
+        \brief Compares a column default value reported by the database with the value expected by the scheme
+        \param actual the default value reported by the database, empty if there is no default
+        \param expected the default value of the scheme
+        \return true if values match
+    */
+    virtual bool sameDefault(const std::string &actual, const SqlValue &expected) const
+    {
+        return actual == expected.toString();
+    }
+
     virtual void performImpl(const std::vector<Statement> &statements, const parseFunc &fn) = 0;
 
     virtual SqlQueryStringBuilder &queryBuilder() = 0;
+
+    /*!
+        \brief Checks if there is at least one observer attached
+        \return true if statements need to be measured
+    */
+    bool observed() const
+    {
+        return _observed.load(std::memory_order_relaxed);
+    }
+
+    /*!
+        \brief Passes statement details to the observers
+        \param stats statement details. Its fingerprint is filled here.
+    */
+    void notify(StatementStats &stats) const;
+
+    /*!
+        \brief Reports a row changed by the database, e.g. by a trigger or a foreign key cascade.
+        Backends which can see such changes (like the Sqlite update hook) call it to keep caches coherent.
+        \param table the table name
+        \param rowid the rowid of the row
+    */
+    void rowChanged(const std::string &table, std::int64_t rowid);
+
+    /*!
+        \brief Records the number of rows changed by a query of the calling thread, see changedRows().
+        Backends call it when they perform statements.
+        \param rows the number of rows
+    */
+    void setChangedRows(std::uint64_t rows);
+
+    /*!
+        \brief Runs a statement executor. If there are observers attached, the executor gets
+        a StatementStats object to fill and the observers are notified when the executor returns or throws.
+        Otherwise the executor gets nullptr and nothing is measured.
+        \param sql statement text
+        \param parameters values bound to the statement
+        \param executor a functor accepting StatementStats*
+    */
+    template <typename ExecutorT>
+    void observe(const std::string &sql, const std::vector<SqlValue> &parameters, ExecutorT &&executor)
+    {
+        if (!observed())
+        {
+            executor(nullptr);
+            return;
+        }
+
+        StatementStats stats;
+        stats.sql = sql;
+        stats.parameters = parameters.size();
+        stats.values = &parameters;
+        try
+        {
+            executor(&stats);
+        }
+        catch (const std::exception &e)
+        {
+            stats.error = e.what();
+            notify(stats);
+            throw;
+        }
+        notify(stats);
+    }
+
+private:
+    friend class Transaction;
+
+    /*!
+        \brief Registers a transaction of the calling thread
+        \return the depth of the transaction, 0 for the outermost one
+    */
+    std::size_t enterTransaction();
+    void leaveTransaction();
+
+    void performStatements(const SqlQuery &query, const std::vector<Statement> &statements, const parseFunc &fn)
+    {
+        if (_cached.load(std::memory_order_relaxed))
+        {
+            performCached(query, statements, fn);
+        }
+        else
+        {
+            performImpl(statements, fn);
+        }
+    }
+
+    /*!
+        \brief Performs a query built into several statements. Outside a transaction the statements of an insert
+        are run in one, so its rows are inserted all or none.
+    */
+    void performSplit(const SqlQuery &query, const std::vector<Statement> &statements, const parseFunc &fn);
+
+    /*!
+        \brief Serves SELECT queries from the result cache and invalidates caches by changes
+    */
+    void performCached(const SqlQuery &query, const std::vector<Statement> &statements, const parseFunc &fn);
+    void updateCached();
+
+    using Observers = std::vector<ConnectionObserver::SPtr>;
+
+    // copy-on-write list, readers take a snapshot with std::atomic_load
+    std::shared_ptr<const Observers> _observers;
+    std::atomic<bool> _observed{false};
+    std::mutex _observersMutex;
+
+    // depth is tracked per thread, a connection pool runs transactions of different threads on different sessions
+    mutable std::mutex _transactionsMutex;
+    std::map<std::thread::id, std::size_t> _transactionDepth;
+    std::map<std::thread::id, std::uint64_t> _changedRows;
+
+    std::recursive_mutex _sessionMutex;
+
+    std::shared_ptr<ResultCache> _resultCache;
+    std::shared_ptr<EntityCache> _entityCache;
+    std::atomic<bool> _cached{false};
 };
 
 } // namespace db
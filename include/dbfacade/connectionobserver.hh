@@ -0,0 +1,126 @@
+#ifndef SOFTEQ_DBFACADE_CONNECTIONOBSERVER_H_
+#define SOFTEQ_DBFACADE_CONNECTIONOBSERVER_H_
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sqlvalue.hh"
+
+namespace softeq
+{
+namespace db
+{
+/*!
+    \brief Execution details of a single statement reported to connection observers
+*/
+struct StatementStats
+{
+    using Clock = std::chrono::steady_clock;
+    using Duration = Clock::duration;
+
+    /*!
+        \brief Statement text as it was sent to the database (values are replaced with placeholders)
+    */
+    std::string sql;
+
+    /*!
+        \brief Normalized statement text (literals are replaced with '?').
+        Statements of the same shape have the same fingerprint.
+    */
+    std::string fingerprint;
+
+    std::size_t parameters = 0; //! number of bound parameters
+    std::size_t rows = 0;       //! number of rows returned
+
+    /*!
+        \brief Bound values. The pointer is valid only during the notification.
+    */
+    const std::vector<SqlValue> *values = nullptr;
+
+    Duration prepare{};     //! time spent to prepare (compile) the statement
+    Duration execute{};     //! time spent to execute the statement (including the first row for Sqlite)
+    Duration fetch{};       //! time spent to fetch rows
+    Duration deserialize{}; //! time spent in the parse function (conversion to C++ structs)
+
+    /*!
+        \brief Error message if the statement failed, empty otherwise
+    */
+    std::string error;
+
+    /*!
+        \brief Total duration of the statement
+        \return sum of all phases
+    */
+    Duration total() const
+    {
+        return prepare + execute + fetch + deserialize;
+    }
+};
+
+/*!
+    \brief Interface for classes that want to be notified about activity on a connection.
+    Observers are called in the thread that performs the statement, so implementations must be thread-safe
+    if the connection is shared between threads. Observers must not throw.
+*/
+class ConnectionObserver
+{
+public:
+    using SPtr = std::shared_ptr<ConnectionObserver>;
+
+    virtual ~ConnectionObserver() = default;
+
+    /*!
+        \brief Called after a statement is completed (either successfully or not)
+        \param stats statement details
+    */
+    virtual void onStatement(const StatementStats &stats) = 0;
+};
+
+/*!
+    \brief Measures durations of statement phases. It does not touch the clock if it is disabled,
+    so it can be left in the execution path at (almost) no cost.
+*/
+class Stopwatch
+{
+public:
+    explicit Stopwatch(bool enabled)
+        : _enabled(enabled)
+        , _start(enabled ? StatementStats::Clock::now() : StatementStats::Clock::time_point())
+    {
+    }
+
+    /*!
+        \brief Returns the time passed since the previous lap (or construction) and starts a new lap
+        \return duration of the lap, zero if the stopwatch is disabled
+    */
+    StatementStats::Duration lap()
+    {
+        if (!_enabled)
+        {
+            return StatementStats::Duration::zero();
+        }
+        auto now = StatementStats::Clock::now();
+        auto elapsed = now - _start;
+        _start = now;
+        return elapsed;
+    }
+
+private:
+    bool _enabled;
+    StatementStats::Clock::time_point _start;
+};
+
+/*!
+    \brief Builds a fingerprint of an SQL statement: numeric and string literals are replaced with '?'
+    and whitespaces are collapsed.
+    \param sql statement text
+    \return normalized statement text
+*/
+std::string fingerprint(const std::string &sql);
+
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_DBFACADE_CONNECTIONOBSERVER_H_
@@ -0,0 +1,181 @@
+#ifndef SOFTEQ_DBFACADE_ENTITYCACHE_H_
+#define SOFTEQ_DBFACADE_ENTITYCACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <type_traits>
+#include <unordered_map>
+
+#include "tablecache.hh"
+#include "tablescheme.hh"
+
+namespace softeq
+{
+namespace db
+{
+/*!
+    \brief Identity map of rows looked up by the primary key with Facade::find, attached to connections by
+    Connection::setEntityCache. Updates, removals, alterations and drops performed through a connection using
+    the cache invalidate the rows of the table; on Sqlite, rows changed by triggers and foreign key cascades
+    are invalidated by the update hook too. Rows are evicted in LRU order when the number of entries or their
+    estimated size exceeds the limits.
+
+    Changes made by other processes can't be seen, so the cache suits data written through the application only.
+    The cache is thread-safe and may be shared by connections to the same database.
+*/
+class EntityCache : public TableCache
+{
+public:
+    using SPtr = std::shared_ptr<EntityCache>;
+
+    struct Options
+    {
+        std::size_t maxEntries = 10000;
+
+        /*!
+            \brief Estimated total size of cached rows in bytes
+        */
+        std::size_t maxBytes = 64 * 1024 * 1024;
+    };
+
+    struct Counters
+    {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t invalidations = 0; //! rows removed because they changed
+        std::uint64_t evictions = 0;     //! rows removed because of the limits
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+
+        /*!
+            \return the share of lookups served from the cache
+        */
+        double hitRate() const
+        {
+            return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses);
+        }
+    };
+
+    EntityCache();
+    explicit EntityCache(const Options &options);
+
+    /*!
+        \brief Converts a primary key value
+        \param key an integer or a string
+        \return the value
+    */
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value, SqlValue>::type keyValue(T key)
+    {
+        return SqlValue(static_cast<std::int64_t>(key));
+    }
+
+    static SqlValue keyValue(const std::string &key)
+    {
+        return SqlValue(std::string(key));
+    }
+
+    /*!
+        \brief Looks a row up
+        \tparam Struct the type of the row
+        \param table the table name
+        \param key the primary key value
+        \return the row or nullptr
+    */
+    template <typename Struct>
+    std::shared_ptr<const Struct> find(const std::string &table, const SqlValue &key)
+    {
+        return std::static_pointer_cast<const Struct>(findEntry(table, key, typeid(Struct)));
+    }
+
+    /*!
+        \brief Returns a value to pass to store(). A row read after the call is stored only if nothing
+        is invalidated in between, so a row read concurrently with a change is not cached.
+    */
+    std::uint64_t generation() const;
+
+    /*!
+        \brief Caches a row
+        \tparam Struct the type of the row
+        \param scheme the scheme of the table
+        \param key the primary key value
+        \param entity the row
+        \param generation the value of generation() taken before the row was read
+    */
+    template <typename Struct>
+    void store(const TableScheme &scheme, const SqlValue &key, const Struct &entity, std::uint64_t generation)
+    {
+        // the size of the struct plus the heap memory its values are likely to take
+        std::size_t bytes = sizeof(Struct);
+        for (Cell cell : scheme.cells())
+        {
+            cell.serialize(entity);
+            if (cell.value().type() != SqlValue::Subtype::Integer)
+            {
+                bytes += cell.value().toString().size();
+            }
+        }
+        storeEntry(scheme.name(), key, std::make_shared<const Struct>(entity), typeid(Struct), bytes, generation);
+    }
+
+    /*!
+        \brief Removes a row changed by the database (e.g. reported by the Sqlite update hook)
+        \param table the table name
+        \param rowid the rowid of the row. It is the primary key of tables with an integer key, rows of other
+        tables can't be found by it, so the whole table is invalidated.
+    */
+    void invalidateRow(const std::string &table, std::int64_t rowid);
+
+    void invalidate(const std::string &table) override;
+    void invalidateOnCommit(const std::string &table) override;
+    void endTransaction() override;
+    void clear() override;
+
+    Counters counters() const;
+    void resetCounters();
+
+private:
+    struct Entry
+    {
+        std::string table;
+        std::string key;
+        std::shared_ptr<const void> entity;
+        std::type_index type{typeid(void)};
+        std::size_t bytes = 0;
+    };
+    using Entries = std::list<Entry>;
+
+    struct Table
+    {
+        std::unordered_map<std::string, Entries::iterator> rows;
+        bool integerKey = true;
+    };
+
+    std::shared_ptr<const void> findEntry(const std::string &table, const SqlValue &key, std::type_index type);
+    void storeEntry(const std::string &table, const SqlValue &key, std::shared_ptr<const void> &&entity,
+                    std::type_index type, std::size_t bytes, std::uint64_t generation);
+    void invalidateLocked(const std::string &table);
+    void erase(Entries::iterator entry);
+
+    Options _options;
+
+    mutable std::mutex _mutex;
+    Entries _entries; // the most recently used first
+    std::map<std::string, Table> _tables;
+    std::map<std::thread::id, std::set<std::string>> _deferred;
+    std::size_t _bytes = 0;
+    std::uint64_t _generation = 0;
+    Counters _counters;
+};
+
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_DBFACADE_ENTITYCACHE_H_
@@ -0,0 +1,118 @@
+#ifndef SOFTEQ_MYSQL_MYSQLASYNCCONNECTION_H_
+#define SOFTEQ_MYSQL_MYSQLASYNCCONNECTION_H_
+
+#include <deque>
+#include <exception>
+
+#include <dbfacade/connection.hh>
+#include "mysqlquerybuilder.hh"
+
+namespace softeq
+{
+namespace db
+{
+namespace mysql
+{
+/*!
+    \brief MySQL session driven by an event loop through the non-blocking client API.
+    Queries are queued by submit() and executed one after another. The owner waits until socket() is ready
+    and calls step(), which does as much work as possible without blocking. Many sessions can be driven
+    by a single thread this way.
+
+    The non-blocking API has no prepared statements, so values are escaped and put into the statement text.
+*/
+class MySqlAsyncConnection
+{
+public:
+    using SPtr = std::shared_ptr<MySqlAsyncConnection>;
+
+    /*!
+        \brief Called when all statements of a query are done
+        \param error nullptr on success, the exception otherwise
+    */
+    using Completion = std::function<void(std::exception_ptr error)>;
+
+    /*!
+        \brief Constructor. Connecting is started by the first step() call.
+    */
+    MySqlAsyncConnection(const std::string &host, const int port, const std::string &userName,
+                         const std::string &password, const std::string &database);
+    ~MySqlAsyncConnection();
+
+    MySqlAsyncConnection(const MySqlAsyncConnection &) = delete;
+    MySqlAsyncConnection &operator=(const MySqlAsyncConnection &) = delete;
+
+    /*!
+        \brief Queues a query
+        \param query the query
+        \param fn receives rows of the result, may be empty
+        \param done called from step() when the query is done, may be empty
+    */
+    void submit(const SqlQuery &query, const Connection::parseFunc &fn, const Completion &done);
+
+    /*!
+        \brief Advances the current work until it has to wait for the server
+        \return true if there is nothing left to do, false if step() must be called again when socket() is ready
+        \throw MySqlException if the session can't be established. Queued queries are failed before that.
+    */
+    bool step();
+
+    /*!
+        \brief The socket to wait on for readiness (both reading and writing while connecting).
+        \return the file descriptor, -1 until the first step() call
+    */
+    int socket() const;
+
+    /*!
+        \return true if there are queued or running queries
+    */
+    bool busy() const;
+
+private:
+    enum class State
+    {
+        Initial,
+        Connecting,
+        Idle,
+        Querying,
+        StoringResult,
+        Fetching,
+        FreeingResult,
+        Failed
+    };
+
+    struct Job
+    {
+        std::vector<Statement> statements;
+        std::size_t next = 0;
+        Connection::parseFunc fn;
+        Completion done;
+        std::exception_ptr error;
+    };
+
+    std::string literal(const SqlValue &value);
+    void finishStatement();
+    void failAll(std::exception_ptr error);
+
+    std::string _host;
+    int _port;
+    std::string _userName;
+    std::string _password;
+    std::string _database;
+
+    MySqlCellRepresentation _cellRepr;
+    MySqlQueryStringBuilder _builder{_cellRepr};
+
+    struct MYSQL *_session;
+    struct MYSQL_RES *_result = nullptr;
+    State _state = State::Initial;
+    std::deque<Job> _jobs;
+    std::string _sqlText;
+    std::map<std::string, int> _header;
+};
+
+} // namespace mysql
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_MYSQL_MYSQLASYNCCONNECTION_H_
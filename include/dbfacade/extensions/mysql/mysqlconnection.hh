@@ -5,6 +5,7 @@
 #include <dbfacade/connection.hh>
 #include <dbfacade/tablescheme.hh>
 #include "mysqlquerybuilder.hh"
+#include "mysqlexception.hh"
 
 namespace softeq
 {
@@ -19,15 +20,56 @@ public:
                     const std::string &database);
     ~MySqlConnection() override;
 
-    void verifyScheme(const TableScheme &scheme) override;
+    QueryPlan explainStatement(const std::string &sql, const std::vector<SqlValue> &parameters) override;
+
+    /*!
+        \brief Checks that the server is reachable. The session is not reconnected.
+        \return true if the server responded
+    */
+    bool ping();
+
+    /*!
+        \brief Checks if an error means the session is lost and can't be used any more
+        \param error the error
+        \return true for "server has gone away" and "lost connection" errors
+    */
+    static bool isConnectionError(const MySqlException &error);
 
 private:
+    friend class MySqlConnectionPool;
+
+    std::vector<ColumnInfo> describeTables(const std::vector<std::string> &tables) override;
+    bool sameType(const std::string &actual, const std::string &expected) const override;
+    bool sameDefault(const std::string &actual, const SqlValue &expected) const override;
+    static bool sameMySqlType(const std::string &actual, const std::string &expected);
+    static bool sameMySqlDefault(const std::string &actual, const SqlValue &expected);
     MySqlQueryStringBuilder &queryBuilder() override;
     void performImpl(const std::vector<Statement> &statement, const parseFunc &) override;
 
+    /*!
+        \brief Prepares and executes a single statement and passes its result to fn
+        \param sqlText statement text
+        \param parameters values to bind
+        \param fn parse function, may be empty
+        \param options the way the result is transferred
+        \param stats statistics to fill, nullptr if they are not collected
+        \return the number of rows the statement inserted, updated or removed
+    */
+    std::uint64_t executeStatement(const std::string &sqlText, std::vector<SqlValue> &parameters, const parseFunc &fn,
+                          const FetchOptions &options, StatementStats *stats);
+
+    /*!
+        \brief Sets the statement limits of the builder according to the server settings
+    */
+    void readStatementLimits();
+
     MySqlCellRepresentation _cellRepr;
     MySqlQueryStringBuilder _builder{_cellRepr};
     struct MYSQL *_session;
+
+    // the last successfully executed statement, reused if the next one has the same text
+    struct MYSQL_STMT *_lastStatement = nullptr;
+    std::string _lastStatementText;
 };
 
 } // namespace mysql
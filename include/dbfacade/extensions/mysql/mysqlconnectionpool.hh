@@ -0,0 +1,161 @@
+#ifndef SOFTEQ_MYSQL_MYSQLCONNECTIONPOOL_H_
+#define SOFTEQ_MYSQL_MYSQLCONNECTIONPOOL_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+#include "mysqlconnection.hh"
+
+namespace softeq
+{
+namespace db
+{
+namespace mysql
+{
+/*!
+    \brief Connection that spreads statements over a pool of MySQL sessions.
+    A session is borrowed for every perform call and validated before use if it has been idle for a while.
+    Broken sessions are replaced transparently. A transaction pins its session to the calling thread
+    until it is committed or rolled back, so Facade::execTransaction works as with a single session.
+    A background thread retires old sessions and keeps standby sessions open.
+*/
+class MySqlConnectionPool : public Connection
+{
+public:
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        int port = 3306;
+        std::string userName;
+        std::string password;
+        std::string database;
+
+        /*!
+            \brief Sessions kept open even if they are not used
+        */
+        std::size_t minSessions = 1;
+
+        /*!
+            \brief Sessions open at most. Callers wait for a free session when all of them are borrowed.
+        */
+        std::size_t maxSessions = 8;
+
+        /*!
+            \brief How long to wait for a free session before throwing
+        */
+        std::chrono::milliseconds borrowTimeout = std::chrono::seconds(5);
+
+        /*!
+            \brief A session idle for longer is pinged before it is used
+        */
+        std::chrono::milliseconds validationInterval = std::chrono::seconds(1);
+
+        /*!
+            \brief Sessions are closed after that time (e.g. to stay below the server wait_timeout).
+            Sessions in a transaction are closed after the transaction ends.
+        */
+        std::chrono::milliseconds maxLifetime = std::chrono::minutes(30);
+
+        /*!
+            \brief How often the background thread checks idle sessions
+        */
+        std::chrono::milliseconds maintenanceInterval = std::chrono::seconds(1);
+    };
+
+    /*!
+        \brief Constructor. Opens minSessions sessions.
+        \param options pool options
+        \throw MySqlException if the sessions can't be opened
+    */
+    explicit MySqlConnectionPool(const Options &options);
+    ~MySqlConnectionPool() override;
+
+    QueryPlan explainStatement(const std::string &sql, const std::vector<SqlValue> &parameters) override;
+
+    /*!
+        \brief Threads get their own sessions and transactions pin them, so there is nothing to lock
+        \return an empty lock
+    */
+    std::unique_lock<std::recursive_mutex> lease() override;
+
+    /*!
+        \return the number of open sessions, both idle and borrowed
+    */
+    std::size_t openSessions() const;
+
+    /*!
+        \return the number of sessions ready to be borrowed
+    */
+    std::size_t idleSessions() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Session
+    {
+        std::unique_ptr<MySqlConnection> connection;
+        Clock::time_point created;
+        Clock::time_point lastUsed;
+        bool inTransaction = false;
+    };
+
+    std::vector<ColumnInfo> describeTables(const std::vector<std::string> &tables) override;
+    bool sameType(const std::string &actual, const std::string &expected) const override;
+    bool sameDefault(const std::string &actual, const SqlValue &expected) const override;
+    MySqlQueryStringBuilder &queryBuilder() override;
+    void performImpl(const std::vector<Statement> &statements, const parseFunc &fn) override;
+
+    /*!
+        \brief Takes the session pinned to the calling thread, a valid idle session or opens a new one
+        \param sqlText the statement the session is borrowed for
+        \return the session. It has no connection if the statement rolls back a transaction which session is lost.
+        \throw MySqlException if there is no free session in time, the server is not reachable or the session
+        of the transaction is lost
+    */
+    Session borrow(const std::string &sqlText);
+
+    /*!
+        \brief Returns a session to the pool. It is pinned to the calling thread while a transaction is open.
+        \param session the session
+        \param sqlText the statement the session was borrowed for
+        \param broken true if the session can't be used any more
+    */
+    void giveBack(Session &&session, const std::string &sqlText, bool broken);
+
+    /*!
+        \brief Runs a function on a borrowed session. If the session turns out to be lost outside a transaction
+        and canRetry allows it, the function is run once more on another session.
+        \param sqlText the statement the session is borrowed for
+        \param canRetry a functor accepting const MySqlException&
+        \param fn a functor accepting MySqlConnection&
+    */
+    template <typename RetryT, typename FuncT>
+    void withSession(const std::string &sqlText, RetryT &&canRetry, FuncT &&fn);
+
+    Session open() const;
+    bool expired(const Session &session, Clock::time_point now) const;
+    void maintain();
+
+    Options _options;
+    MySqlCellRepresentation _cellRepr;
+    MySqlQueryStringBuilder _builder{_cellRepr};
+    std::string _commitText;
+    std::string _rollbackText;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _released;
+    std::vector<Session> _idle;
+    std::map<std::thread::id, Session> _pinned;
+    std::size_t _open = 0;
+
+    bool _stopping = false;
+    std::condition_variable _wakeMaintenance;
+    std::thread _maintenance;
+};
+
+} // namespace mysql
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_MYSQL_MYSQLCONNECTIONPOOL_H_
@@ -14,6 +14,27 @@ class MySqlException : public SqlException
 public:
     explicit MySqlException(const std::string &message);
     explicit MySqlException(const std::string &message, const std::string &query);
+
+    /*!
+        \brief Constructor
+        \param message error message
+        \param query the statement that failed
+        \param errorCode client or server error number (e.g. mysql_errno())
+    */
+    explicit MySqlException(const std::string &message, const std::string &query, unsigned int errorCode);
+
+    /*!
+        \return client or server error number, 0 if it is unknown
+    */
+    unsigned int errorCode() const;
+
+    /*!
+        \return true for a deadlock (ER_LOCK_DEADLOCK) and a lock wait timeout (ER_LOCK_WAIT_TIMEOUT)
+    */
+    bool retryable() const override;
+
+private:
+    unsigned int _errorCode = 0;
 };
 
 } // namespace mysql
@@ -21,6 +21,9 @@ public:
 
 class MySqlQueryStringBuilder : public SqlQueryStringBuilder
 {
+protected:
+    std::vector<Token> valueList(const Token &list) const override;
+
 public:
     MySqlQueryStringBuilder(CellRepresentation &cellRepr);
 
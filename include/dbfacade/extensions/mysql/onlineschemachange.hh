@@ -0,0 +1,129 @@
+#ifndef SOFTEQ_MYSQL_ONLINESCHEMACHANGE_H_
+#define SOFTEQ_MYSQL_ONLINESCHEMACHANGE_H_
+
+#include <chrono>
+#include <cstdint>
+
+#include <dbfacade/alter.hh>
+#include <dbfacade/connection.hh>
+
+namespace softeq
+{
+namespace db
+{
+namespace mysql
+{
+/*!
+    \brief Applies an AlterQuery to a large MySQL table without blocking writes for the whole alteration.
+    The alteration is applied to an empty shadow copy of the table. Rows are copied to it in primary key order
+    chunk by chunk, while triggers on the original table replay concurrent changes. Finally the tables are swapped
+    by a single atomic RENAME TABLE.
+
+    The table must have a single column primary key which is not dropped. Table renames are not supported.
+    Tables with foreign keys, either declared by the table or referencing it, are refused: the shadow table doesn't
+    get them and the referencing ones would follow the original table to its old name.
+*/
+class OnlineSchemaChange
+{
+public:
+    struct Progress
+    {
+        std::uint64_t copiedRows = 0;
+        std::uint64_t estimatedRows = 0; //! from the table statistics, may be inaccurate
+        std::size_t chunks = 0;
+        std::chrono::milliseconds lastChunk{0}; //! time the last chunk took
+    };
+
+    struct Options
+    {
+        /*!
+            \brief Rows copied by a single statement
+        */
+        std::size_t chunkSize = 1000;
+
+        /*!
+            \brief Called after every chunk
+        */
+        std::function<void(const Progress &)> onProgress;
+
+        /*!
+            \brief Called after every chunk, returns the pause before the next one (e.g. depending on replication
+            lag or the load). There is no pause if it is not set.
+        */
+        std::function<std::chrono::milliseconds(const Progress &)> throttle;
+
+        /*!
+            \brief Keep the original table renamed to _<table>_old after the swap
+        */
+        bool keepOldTable = false;
+    };
+
+    /*!
+        \brief Constructor
+        \param connection connection to run the change on. A pool can't be used, the swap must happen
+        on the session which created the triggers.
+        \param alter the alteration
+        \param options options
+        \throw SqlException if the alteration can't be done online
+    */
+    OnlineSchemaChange(const Connection::SPtr &connection, const AlterQuery &alter, const Options &options);
+
+    /*!
+        \brief Runs the change. If it fails before the swap, the triggers and the shadow table are removed
+        and the original table stays intact.
+        \throw SqlException on failure or if the table has foreign keys
+    */
+    void run();
+
+private:
+    void execute(std::vector<Token> &&tokens);
+    std::vector<std::string> fetchColumn(std::vector<Token> &&tokens);
+    void checkForeignKeys();
+    void createShadow();
+    void createTriggers();
+    void copyRows();
+    void swap();
+    void cleanUp();
+
+    Connection::SPtr _connection;
+    AlterQuery _alter;
+    Options _options;
+
+    std::string _table;
+    std::string _shadowTable;
+    std::string _oldTable;
+    std::string _sourceKey;
+    std::string _targetKey;
+    std::vector<std::string> _sourceColumns;
+    std::vector<std::string> _targetColumns;
+};
+
+namespace query
+{
+/*!
+    \brief Forms an online change of a table from the OldStruct scheme to the NewStruct one
+    \tparam <OldStruct> the current scheme of the table
+    \tparam <NewStruct> the scheme to convert to
+    \param connection connection to run the change on
+    \param options options
+    \param renames columns to rename instead of dropping and adding them
+*/
+template <typename OldStruct, typename NewStruct>
+OnlineSchemaChange onlineAlterScheme(const Connection::SPtr &connection,
+                                     const OnlineSchemaChange::Options &options = OnlineSchemaChange::Options(),
+                                     const std::vector<std::pair<CellMaker, CellMaker>> &renames = {})
+{
+    auto alter = db::query::alterScheme<OldStruct, NewStruct>();
+    for (const auto &rename : renames)
+    {
+        alter.renamingCell(rename.first, rename.second);
+    }
+    return OnlineSchemaChange(connection, alter, options);
+}
+} // namespace query
+
+} // namespace mysql
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_MYSQL_ONLINESCHEMACHANGE_H_
@@ -1,7 +1,16 @@
 #ifndef SOFTEQ_DBFACADE_FACADE_H_
 #define SOFTEQ_DBFACADE_FACADE_H_
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <set>
+
 #include "connection.hh"
+#include "transaction.hh"
+#include "select.hh"
+#include "update.hh"
 
 namespace softeq
 {
@@ -135,23 +144,139 @@ public:
     {
         return retrieve<std::tuple<Single...>>();
     }
+
+    /*!
+        \brief Converts the result of a one-to-many join into parents holding their children, e.g.
+        receive(select<Author>({...}).join<Book>(...).orderBy(...)).group(&Author::id, &Author::books).
+        The rows of a parent must be adjacent (the query is ordered by the parent key), so each parent is
+        deserialized once when its key changes and the rest of its rows fill the children only.
+        Columns are matched by name, a column both structs have is read into the parent (as for tuples).
+        Rows with all child columns NULL add no child.
+        \param key the parent key member, it must be selected
+        \param children the parent member the children are stored to
+        \return the parents in the order of the result
+        \throw SqlException if the key is not selected, the rows of a parent are not adjacent or on perform error
+    */
+    template <typename Parent, typename Child, typename KeyT>
+    std::vector<Parent> group(KeyT Parent::*key, std::vector<Child> Parent::*children)
+    {
+        const std::string keyName = CellMaker(key)().unqualifiedName();
+        const TableScheme parentScheme = buildTableScheme<Parent>();
+        const TableScheme childScheme = buildTableScheme<Child>();
+
+        std::vector<Parent> result;
+        std::vector<std::pair<int, Cell>> parentColumns;
+        std::vector<std::pair<int, Cell>> childColumns;
+        int keyIndex = -1;
+        std::string lastKey;
+        std::set<std::string> seen;
+
+        auto parseFunc = [&](const std::map<std::string, int> &header, const std::vector<const char *> &row) {
+            if (keyIndex < 0)
+            {
+                for (const auto &col : header)
+                {
+                    auto cell = parentScheme.findCell(col.first);
+                    if (cell.second)
+                    {
+                        parentColumns.emplace_back(col.second, cell.first);
+                        keyIndex = col.first == keyName ? col.second : keyIndex;
+                        continue;
+                    }
+                    cell = childScheme.findCell(col.first);
+                    if (!cell.second)
+                    {
+                        throw SqlException("unknown cell: " + col.first);
+                    }
+                    childColumns.emplace_back(col.second, cell.first);
+                }
+                if (keyIndex < 0)
+                {
+                    throw SqlException("the key of '" + parentScheme.name() + "' is not selected");
+                }
+            }
+
+            std::string rowKey = row[keyIndex] ? row[keyIndex] : "";
+            if (result.empty() || rowKey != lastKey)
+            {
+                if (!seen.insert(rowKey).second)
+                {
+                    throw SqlException("rows of '" + parentScheme.name() + "' " + rowKey +
+                                       " are not adjacent, the query must be ordered by the key");
+                }
+                result.emplace_back();
+                for (const auto &column : parentColumns)
+                {
+                    column.second.deserialize(row[column.first], result.back());
+                }
+                lastKey = std::move(rowKey);
+            }
+
+            bool hasChild = false;
+            for (const auto &column : childColumns)
+            {
+                hasChild = hasChild || row[column.first];
+            }
+            if (hasChild)
+            {
+                Child child;
+                for (const auto &column : childColumns)
+                {
+                    column.second.deserialize(row[column.first], child);
+                }
+                (result.back().*children).push_back(std::move(child));
+            }
+        };
+
+        _connection->perform(_query, parseFunc);
+        return result;
+    }
 };
 
+class Transaction;
+
 /*!
-    \brief Class provides a simple interface to sql-like databases
+    \brief Progress of a query executed in chunks (see Facade::executeInChunks)
 */
-class Facade
+struct ChunkProgress
+{
+    std::size_t chunks = 0; //! committed chunks
+    std::size_t rows = 0;   //! rows matched by the committed chunks
+};
+
+/*!
+    \brief Options of a query executed in chunks (see Facade::executeInChunks)
+*/
+struct ChunkOptions
 {
     /*!
-        \brief Executes a query which begins a transaction
+        \brief The number of rows a chunk processes
     */
-    void beginTransaction();
+    std::size_t chunkSize = 1000;
 
     /*!
-        \brief Executes a query which ends a transaction
-        \param commit bool wheather we need to commit a transaction
+        \brief The time to wait between chunks, it lets other writers take the lock
     */
-    void endTransaction(bool commit = true);
+    std::chrono::milliseconds pause{0};
+
+    /*!
+        \brief Options of the transaction of each chunk. A chunk reads its keys before it writes, so the write lock
+        is taken at once: upgrading a read lock fails with SQLITE_BUSY while another connection writes.
+    */
+    TransactionOptions transaction = TransactionOptions::immediate();
+
+    /*!
+        \brief Called after each committed chunk, the execution stops if it returns false
+    */
+    std::function<bool(const ChunkProgress &)> progress;
+};
+
+/*!
+    \brief Class provides a simple interface to sql-like databases
+*/
+class Facade
+{
+    friend class Transaction;
 
 public:
     explicit Facade(Connection::SPtr connection)
@@ -182,10 +307,38 @@ public:
         database queries called in transactionFunction will be executed
         inside a transaction.
         If transactionFunction returns true, the transaction will be commited,
-        otherwise it will be rolled back.
+        otherwise (or if it throws) it will be rolled back.
+        A call made inside another transaction of the same thread and connection sets a savepoint, so only
+        the changes of the nested function are undone on rollback.
+        \param transactionFunction the function to execute.
+    */
+    void execTransaction(std::function<bool(Facade &)> transactionFunction)
+    {
+        execTransaction(TransactionOptions(), std::move(transactionFunction));
+    }
+
+    /*!
+        \brief Executes its argument in a transaction started with the options.
+        The options are ignored by nested calls, they apply to the outermost transaction only.
+        \param options the options
         \param transactionFunction the function to execute.
     */
-    void execTransaction(std::function<bool(Facade &)> transactionFunction);
+    void execTransaction(const TransactionOptions &options, std::function<bool(Facade &)> transactionFunction);
+
+    /*!
+        \brief Begins a transaction which lasts until the returned guard is committed, rolled back or destroyed.
+        \param options options of the transaction, ignored if it is nested
+        \return the transaction guard
+    */
+    Transaction transaction(const TransactionOptions &options = TransactionOptions());
+
+    /*!
+        \return the number of unfinished execTransaction calls of the calling thread on the connection
+    */
+    std::size_t transactionDepth() const
+    {
+        return _connection->transactionDepth();
+    }
 
     /*!
         \brief Executes its arguments in a transacted way and commits the transaction.
@@ -200,6 +353,19 @@ public:
         });
     }
 
+    /*!
+        \brief Executes a DELETE or an UPDATE of a large number of rows as a series of short transactions, so other
+        writers are not blocked for long. Each chunk reads the next options.chunkSize primary keys of the matching
+        rows in the key order and changes the rows of that key range. The table must have a single column primary
+        key.
+        \param query a RemoveQuery or an UpdateQuery, its condition selects the rows
+        \param options chunk size, pauses, transaction options and the progress callback
+        \return the progress
+        \throw SqlException if it is called inside a transaction, for other queries or on perform error.
+        Chunks committed before an error stay committed.
+    */
+    ChunkProgress executeInChunks(const SqlQuery &query, const ChunkOptions &options = ChunkOptions());
+
     /*!
         \brief Delivers your generated query to the database.
         The method is designed to RETURN DATA from the database.
@@ -210,6 +376,149 @@ public:
         return DataRetriever(_connection, query);
     }
 
+    /*!
+        \brief Looks a row up by its primary key. If an entity cache is attached to the connection
+        (see Connection::setEntityCache), the row is served from memory when it is possible. The cache is bypassed
+        inside transactions, which may see their own uncommitted changes.
+        \tparam Struct the row type, its table must have a single column primary key
+        \param key the primary key value, an integer or a string
+        \return the row and true, or false if there is no such row
+        \throw SqlException on perform error
+    */
+    template <typename Struct, typename KeyT>
+    std::pair<Struct, bool> find(const KeyT &key)
+    {
+        const TableScheme scheme = buildTableScheme<Struct>();
+        const SqlValue value = EntityCache::keyValue(key);
+
+        EntityCache::SPtr cache = _connection->transactionDepth() == 0 ? _connection->entityCache() : nullptr;
+        if (cache)
+        {
+            auto cached = cache->template find<Struct>(scheme.name(), value);
+            if (cached)
+            {
+                return {*cached, true};
+            }
+        }
+
+        const std::uint64_t generation = cache ? cache->generation() : 0;
+        std::vector<Struct> rows = receive(query::select<Struct>({}).where(Condition(primaryKey(scheme)) == value));
+        if (rows.empty())
+        {
+            return {Struct(), false};
+        }
+        if (cache)
+        {
+            cache->store(scheme, value, rows.front(), generation);
+        }
+        return {std::move(rows.front()), true};
+    }
+
+    /*!
+        \brief Writes the columns of a tracked entity changed since its snapshot (see query::update for a Tracked)
+        and takes a new snapshot
+        \tparam Struct the row type, its table must have a primary key
+        \param entity the entity
+        \param optimistic if true, the row is updated only if the changed columns still have the snapshot values
+        \return false if no row was updated: the row was removed or, for an optimistic update, another writer has
+        changed it. The snapshot is kept then, so the entity may be read again and merged. True if the row was
+        updated or nothing has changed.
+        \throw SqlException on perform error
+    */
+    template <typename Struct>
+    bool update(Tracked<Struct> &entity, bool optimistic = false)
+    {
+        if (!entity.dirty())
+        {
+            return true;
+        }
+        _connection->perform(query::update(entity, optimistic));
+        if (_connection->changedRows() == 0)
+        {
+            return false;
+        }
+        entity.commit();
+        return true;
+    }
+
+    /*!
+        \brief Loads the children of a batch of parents with a few queries instead of a query per parent.
+        The relation is taken from the foreign key of the child table referencing the parent key column.
+        Children are read by 'WHERE fk IN (...)' queries of up to chunkSize keys and grouped in a single pass.
+        \tparam Child the child row type
+        \param parents the parents, their keys may repeat
+        \param key the parent member referenced by the foreign key
+        \param chunkSize the number of keys read by one query
+        \return the children of each parent key, parents without children get empty vectors
+        \throw SqlException if there is no such foreign key or several of them, or on perform error
+    */
+    template <typename Child, typename Parent, typename KeyT>
+    std::map<KeyT, std::vector<Child>> loadRelated(const std::vector<Parent> &parents, KeyT Parent::*key,
+                                                   std::size_t chunkSize = 500)
+    {
+        const Cell parentKey = CellMaker(key)();
+        const Cell childKey = foreignKey(buildTableScheme<Child>(), parentKey);
+
+        std::map<KeyT, std::vector<Child>> related;
+        std::map<std::string, std::pair<SqlValue, const KeyT *>> keys; // the text of a value -> the value, the key
+        for (const Parent &parent : parents)
+        {
+            Cell cell = parentKey;
+            cell.serialize(parent);
+            auto inserted = related.emplace(parent.*key, std::vector<Child>());
+            keys.emplace(cell.value().toString(), std::make_pair(cell.value(), &inserted.first->first));
+        }
+
+        std::vector<Condition> values;
+        auto readChunk = [this, &childKey, &keys, &related, &values]() {
+            const Condition condition{Operator::IN, Condition(childKey), Condition(values)};
+            std::vector<Child> children = receive(query::select<Child>({}).where(condition));
+            values.clear();
+            for (Child &child : children)
+            {
+                Cell cell = childKey;
+                cell.serialize(child);
+                auto parent = keys.find(cell.value().toString());
+                if (parent != keys.end())
+                {
+                    related[*parent->second.second].push_back(std::move(child));
+                }
+            }
+        };
+        for (const auto &value : keys)
+        {
+            values.emplace_back(value.second.first);
+            if (values.size() == std::max<std::size_t>(chunkSize, 1))
+            {
+                readChunk();
+            }
+        }
+        if (!values.empty())
+        {
+            readChunk();
+        }
+        return related;
+    }
+
+    /*!
+        \brief Loads the children of a batch of parents into a member of each parent (see the other overload)
+        \tparam Child the child row type
+        \param parents the parents
+        \param key the parent member referenced by the foreign key
+        \param children the parent member the children are stored to
+        \param chunkSize the number of keys read by one query
+    */
+    template <typename Child, typename Parent, typename KeyT>
+    void loadRelated(std::vector<Parent> &parents, KeyT Parent::*key, std::vector<Child> Parent::*children,
+                     std::size_t chunkSize = 500)
+    {
+        std::map<KeyT, std::vector<Child>> related = loadRelated<Child>(parents, key, chunkSize);
+        for (Parent &parent : parents)
+        {
+            parent.*children = related[parent.*key];
+        }
+    }
+
     /*!
         \brief Verify if actual table matches the scheme,
         Throws an exception if it does not.
@@ -221,8 +530,97 @@ public:
         _connection->verifyScheme(buildTableScheme<TableT>());
     }
 
+    /*!
+        \brief Verify if actual tables match their schemes. Catalog data of all tables is fetched by a single query.
+        Throws SchemeException with all mismatches found.
+        \tparam TableTs the schemes we except the tables to match
+    */
+    template <typename... TableTs>
+    void verifySchemes()
+    {
+        _connection->verifySchemes({buildTableScheme<TableTs>()...});
+    }
+
+    /*!
+        \brief Finds the primary key of a table
+        \param scheme the scheme of the table
+        \return the primary key cell
+        \throw SqlException if the table has no primary key or it is made of several columns
+    */
+    static Cell primaryKey(const TableScheme &scheme);
+
+private:
+    template <typename QueryT>
+    ChunkProgress executeChunked(const QueryT &query, const ChunkOptions &options);
+
+    /*!
+        \brief Finds the foreign key of a table referencing a column
+        \param scheme the scheme of the referencing table
+        \param referenced the referenced column, qualified with its table
+        \return the referencing column, qualified with its table
+        \throw SqlException if there is no such foreign key or several of them
+    */
+    static Cell foreignKey(const TableScheme &scheme, const Cell &referenced);
+
+    Connection::SPtr _connection;
+};
+
+/*!
+    \brief A transaction which is rolled back on destruction unless it is committed.
+    The connection is leased to the thread which began the transaction until the transaction ends, so statements
+    of other threads using the same connection wait instead of getting into it. Hence the transaction must be ended
+    on the thread which began it.
+
+    A transaction begun while another one of the same thread is active on the connection is nested: it sets
+    a savepoint and only undoes its own changes on rollback. Nested transactions must end before the outer one.
+*/
+class Transaction
+{
+public:
+    /*!
+        \brief Begins a transaction
+        \param facade the facade to run statements of the transaction
+        \param options options of the transaction, ignored if it is nested
+    */
+    explicit Transaction(Facade &facade, const TransactionOptions &options = TransactionOptions());
+
+    Transaction(Transaction &&other);
+    Transaction &operator=(Transaction &&other);
+    Transaction(const Transaction &) = delete;
+    Transaction &operator=(const Transaction &) = delete;
+
+    /*!
+        \brief Rolls the transaction back if it is still active, errors are ignored
+    */
+    ~Transaction();
+
+    /*!
+        \brief Commits the transaction (releases the savepoint of a nested one).
+        If the commit fails, the transaction is rolled back.
+        \throw SqlException if the transaction is not active or the commit fails
+    */
+    void commit();
+
+    /*!
+        \brief Rolls the transaction back
+        \throw SqlException if the transaction is not active or the rollback fails
+    */
+    void rollback();
+
+    /*!
+        \return true until the transaction is committed or rolled back
+    */
+    bool active() const;
+
 private:
+    void end(bool commit);
+    void abort();
+    void finish();
+
     Connection::SPtr _connection;
+    std::unique_lock<std::recursive_mutex> _lease;
+    std::size_t _depth = 0;
+    bool _active = false;
 };
 
 } // namespace db
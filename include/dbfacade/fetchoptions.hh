@@ -0,0 +1,56 @@
+#ifndef SOFTEQ_DBFACADE_FETCHOPTIONS_H_
+#define SOFTEQ_DBFACADE_FETCHOPTIONS_H_
+
+#include <cstdint>
+
+namespace softeq
+{
+namespace db
+{
+/*!
+    \brief The struct describes how rows of a result are transferred from the database server.
+    Backends that do not have a choice (e.g. Sqlite, which always steps through the result) ignore it.
+*/
+struct FetchOptions
+{
+    enum class Mode
+    {
+        Buffered, //! the whole result is transferred to the client at once, memory grows with the result
+        Streaming //! rows are fetched through a read-only server-side cursor, memory is bounded
+    };
+
+    Mode mode = Mode::Buffered;
+
+    /*!
+        \brief The number of rows fetched from the cursor at a time in Streaming mode
+    */
+    std::uint32_t prefetchRows = 1;
+
+    /*!
+        \brief Creates options to transfer the whole result at once. Fewer round-trips, suits small
+        and medium results.
+        \return the options
+    */
+    static FetchOptions buffered()
+    {
+        return FetchOptions();
+    }
+
+    /*!
+        \brief Creates options to fetch rows through a server-side cursor. Suits large scans.
+        \param prefetchRows the number of rows fetched at a time
+        \return the options
+    */
+    static FetchOptions streaming(std::uint32_t prefetchRows = 100)
+    {
+        FetchOptions options;
+        options.mode = Mode::Streaming;
+        options.prefetchRows = prefetchRows;
+        return options;
+    }
+};
+
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_DBFACADE_FETCHOPTIONS_H_
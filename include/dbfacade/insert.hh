@@ -15,6 +15,26 @@ class InsertQuery : public SerializableSqlQuery<InsertQuery>
 {
 public:
     explicit InsertQuery(const TableScheme &scheme);
+
+    /*!
+        \brief Makes the query insert several rows at once. Cells of the first row define the inserted columns.
+        \param[in] rows serialized rows, all of them having the same columns
+    */
+    void setRows(std::vector<std::vector<Cell>> &&rows);
+
+    /*!
+        \return rows set by setRows
+    */
+    const std::vector<std::vector<Cell>> &rows() const;
+
+    /*!
+        \return true if the query inserts rows set by setRows rather than its cells
+    */
+    bool isBulk() const;
+
+private:
+    std::vector<std::vector<Cell>> _rows;
+    bool _bulk = false;
 };
 
 namespace query
@@ -63,6 +83,37 @@ InsertQuery insert(std::initializer_list<CellMaker> fields, const Struct &data)
     return query;
 }
 
+/*!
+    \brief Forms an INSERT query that puts many rows into the database with as few statements as possible.
+    Rows are packed into multi-row VALUES lists split by the statement limits of the connection. If there are
+    several statements, a connection runs them in a transaction of their own unless it is already in one, so either
+    all the rows are inserted or none.
+    \tparam <Struct> containing the schema of the database table if the type is passed implicitly
+    \param[in] data Structs filled with data to be inserted into a table
+*/
+template <typename Struct>
+InsertQuery insert(const std::vector<Struct> &data)
+{
+    auto scheme = buildTableScheme<Struct>();
+    const std::vector<Cell> cells = scheme.cells();
+
+    std::vector<std::vector<Cell>> rows;
+    rows.reserve(data.size());
+    for (const Struct &single : data)
+    {
+        rows.push_back(cells);
+        for (Cell &cell : rows.back())
+        {
+            cell.serialize(single);
+        }
+    }
+
+    InsertQuery query(scheme);
+    query.setRows(std::move(rows));
+
+    return query;
+}
+
 } // namespace query
 
 } // namespace db
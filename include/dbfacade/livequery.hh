@@ -0,0 +1,310 @@
+#ifndef SOFTEQ_DBFACADE_LIVEQUERY_H_
+#define SOFTEQ_DBFACADE_LIVEQUERY_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "facade.hh"
+#include "select.hh"
+#include "sqliteconnection.hh"
+
+namespace softeq
+{
+namespace db
+{
+/*!
+    \brief A SELECT query kept up to date by the change notifications of a Sqlite connection
+    (see SqliteConnection::subscribe). The changes of a committed transaction are evaluated at once and the rows
+    which were inserted into, updated in or removed from the result are passed to the handler.
+
+    Changes of the main table are evaluated by re-reading the changed rows only (by the rowid, which is the primary
+    key of tables with an integer key). Changes of joined tables, queries with a limit and tables with other keys
+    make the whole query be re-read and compared with the previous result.
+
+    Rows are identified by the primary key of the main table, so it must be selected and a row must appear in the
+    result once (joined tables may be referenced many-to-one only). Tables referenced by subqueries in the condition
+    are not tracked.
+
+    The handler is called on the thread which committed the changes, after the commit statement.
+*/
+template <typename Struct>
+class LiveQuery final
+{
+public:
+    /*!
+        \brief Rows changed in the result by a transaction
+    */
+    struct Delta
+    {
+        std::vector<Struct> inserted;
+        std::vector<Struct> updated;
+        std::vector<Struct> deleted; //! the rows as they were before the removal
+
+        bool empty() const
+        {
+            return inserted.empty() && updated.empty() && deleted.empty();
+        }
+    };
+
+    struct Counters
+    {
+        std::uint64_t partialEvaluations = 0; //! changed rows re-read
+        std::uint64_t fullEvaluations = 0;    //! the whole query re-read
+    };
+
+    using Handler = std::function<void(const Delta &)>;
+
+    /*!
+        \brief Reads the query and subscribes to the changes of the tables it reads
+        \param connection the connection the changes are made through
+        \param query the query
+        \param handler the handler of non-empty deltas
+        \throw SqlException if the main table has no single column primary key or the key is not selected
+    */
+    LiveQuery(const std::shared_ptr<SqliteConnection> &connection, const SelectQuery &query, const Handler &handler)
+        : _connection(connection)
+        , _query(query)
+        , _handler(handler)
+        , _key(Facade::primaryKey(query.scheme()))
+    {
+        bool keySelected = false;
+        for (const Cell &cell : query.cells().empty() ? query.scheme().cells() : query.cells())
+        {
+            // cells of joined tables can't be read from the struct
+            if (cell.tableName().empty() || cell.tableName() == query.table())
+            {
+                _cells.push_back(cell);
+                keySelected = keySelected || cell.unqualifiedName() == _key.unqualifiedName();
+            }
+        }
+        if (!keySelected)
+        {
+            throw SqlException("Live query of '" + query.table() + "' must select the primary key");
+        }
+
+        Cell probe = _key;
+        probe.serialize(Struct());
+        _rowidKey = probe.value().type() == SqlValue::Subtype::Integer;
+
+        std::set<std::string> tables{query.table()};
+        for (const Join &join : query.joins())
+        {
+            tables.insert(join.name());
+        }
+        for (const Cell &cell : query.cells())
+        {
+            if (!cell.tableName().empty())
+            {
+                tables.insert(cell.tableName());
+            }
+        }
+
+        // changes are delivered by the thread holding the connection, so none is missed in between
+        auto lease = _connection->lease();
+        _rows = read(_query);
+        _subscription = _connection->subscribe(
+            tables, [this](const std::vector<SqliteConnection::RowChange> &changes) { refresh(changes); });
+    }
+
+    ~LiveQuery()
+    {
+        // waits for a delivery in progress
+        auto lease = _connection->lease();
+        _connection->unsubscribe(_subscription);
+    }
+
+    LiveQuery(const LiveQuery &) = delete;
+    LiveQuery &operator=(const LiveQuery &) = delete;
+
+    /*!
+        \return the current result, ordered by the primary key
+    */
+    std::vector<Struct> rows() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<Struct> rows;
+        rows.reserve(_rows.size());
+        for (const auto &row : _rows)
+        {
+            rows.push_back(row.second);
+        }
+        return rows;
+    }
+
+    Counters counters() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _counters;
+    }
+
+private:
+    /*!
+        \brief Orders primary key values: integers by their value, other values by their text
+    */
+    struct KeyLess
+    {
+        bool operator()(const SqlValue &lhs, const SqlValue &rhs) const
+        {
+            const bool lhsInteger = lhs.type() == SqlValue::Subtype::Integer;
+            const bool rhsInteger = rhs.type() == SqlValue::Subtype::Integer;
+            if (lhsInteger && rhsInteger)
+            {
+                return lhs.intValue() < rhs.intValue();
+            }
+            if (lhsInteger != rhsInteger)
+            {
+                return lhsInteger;
+            }
+            return lhs.toString() < rhs.toString();
+        }
+    };
+
+    using Keys = std::set<SqlValue, KeyLess>;
+    using Rows = std::map<SqlValue, Struct, KeyLess>;
+
+    /*!
+        \brief More changed rows than that are evaluated by re-reading the whole query
+    */
+    static constexpr std::size_t maxPartialRows = 500;
+
+    SqlValue keyOf(const Struct &row) const
+    {
+        Cell key = _key;
+        key.serialize(row);
+        return key.value();
+    }
+
+    bool same(const Struct &lhs, const Struct &rhs) const
+    {
+        for (Cell cell : _cells)
+        {
+            cell.serialize(lhs);
+            const SqlValue value = cell.value();
+            cell.serialize(rhs);
+            if (value.type() != cell.value().type() || value.toString() != cell.value().toString())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Rows read(const SelectQuery &query) const
+    {
+        std::vector<Struct> rows = Facade(_connection).receive(query);
+        Rows keyed;
+        for (Struct &row : rows)
+        {
+            SqlValue key = keyOf(row);
+            keyed.emplace(std::move(key), std::move(row));
+        }
+        return keyed;
+    }
+
+    void refresh(const std::vector<SqliteConnection::RowChange> &changes)
+    {
+        std::set<std::int64_t> rowids;
+        bool full = !_rowidKey || _query.limits().defined();
+        for (const SqliteConnection::RowChange &change : changes)
+        {
+            if (change.table == _query.table())
+            {
+                rowids.insert(change.rowid);
+            }
+            else
+            {
+                full = true;
+            }
+        }
+        full = full || rowids.size() > maxPartialRows;
+
+        // only the thread holding the connection changes the rows, so they are read without the lock
+        Rows fresh;
+        Keys keys;
+        if (full)
+        {
+            fresh = read(_query);
+            for (const auto &row : _rows)
+            {
+                keys.insert(row.first);
+            }
+            for (const auto &row : fresh)
+            {
+                keys.insert(row.first);
+            }
+        }
+        else
+        {
+            std::vector<Condition> values;
+            for (std::int64_t rowid : rowids)
+            {
+                values.emplace_back(SqlValue(rowid));
+                keys.insert(SqlValue(rowid));
+            }
+            const Condition changed{Operator::IN, Condition(_key), Condition(values)};
+            SelectQuery query = _query;
+            query.where(_query.condition().hasValue() ? Condition{Operator::AND, _query.condition(), changed}
+                                                      : changed);
+            fresh = read(query);
+        }
+
+        Delta delta;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++(full ? _counters.fullEvaluations : _counters.partialEvaluations);
+            for (const SqlValue &key : keys)
+            {
+                auto before = _rows.find(key);
+                auto after = fresh.find(key);
+                if (after == fresh.end())
+                {
+                    if (before != _rows.end())
+                    {
+                        delta.deleted.push_back(std::move(before->second));
+                        _rows.erase(before);
+                    }
+                }
+                else if (before == _rows.end())
+                {
+                    delta.inserted.push_back(after->second);
+                    _rows.emplace(key, std::move(after->second));
+                }
+                else if (!same(before->second, after->second))
+                {
+                    delta.updated.push_back(after->second);
+                    before->second = std::move(after->second);
+                }
+            }
+        }
+        if (!delta.empty())
+        {
+            _handler(delta);
+        }
+    }
+
+    std::shared_ptr<SqliteConnection> _connection;
+    SelectQuery _query;
+    Handler _handler;
+    Cell _key;
+    std::vector<Cell> _cells; // compared to find updated rows
+    bool _rowidKey = false;
+    SqliteConnection::SubscriptionId _subscription = 0;
+
+    mutable std::mutex _mutex;
+    Rows _rows;
+    Counters _counters;
+};
+
+template <typename Struct>
+constexpr std::size_t LiveQuery<Struct>::maxPartialRows;
+
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_DBFACADE_LIVEQUERY_H_
@@ -23,6 +23,12 @@ struct OrderBy
     {
     }
 
+    explicit OrderBy(const Cell &cell, OrderType order = ASC)
+        : cell(cell)
+        , order(order)
+    {
+    }
+
     template <typename Struct, typename T>
     OrderBy(T Struct::*member)
         : cell(CellMaker(member)())
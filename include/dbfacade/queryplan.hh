@@ -0,0 +1,41 @@
+#ifndef SOFTEQ_DBFACADE_QUERYPLAN_H_
+#define SOFTEQ_DBFACADE_QUERYPLAN_H_
+
+#include <string>
+#include <vector>
+
+namespace softeq
+{
+namespace db
+{
+/*!
+    \brief Execution plan of a statement returned by the database (e.g. EXPLAIN QUERY PLAN in Sqlite
+    or EXPLAIN in MySQL) converted to a backend-independent form.
+*/
+struct QueryPlan
+{
+    /*!
+        \brief A single step of the plan
+    */
+    struct Step
+    {
+        std::string detail;    //! the step as it was reported by the database
+        std::string table;     //! table the step accesses, empty if the step does not access a table
+        std::string index;     //! index used to access the table, empty if no index is used
+        bool fullScan = false; //! true if all rows of the table are visited
+        std::string temporary; //! what a temporary structure is built for (e.g. "ORDER BY"), empty if none
+    };
+
+    std::vector<Step> steps;
+
+    /*!
+        \brief Returns details of all steps, one per line
+        \return the string representation
+    */
+    std::string toString() const;
+};
+
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_DBFACADE_QUERYPLAN_H_
@@ -0,0 +1,93 @@
+#ifndef SOFTEQ_DBFACADE_QUERYSTATISTICS_H_
+#define SOFTEQ_DBFACADE_QUERYSTATISTICS_H_
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+#include "connectionobserver.hh"
+
+namespace softeq
+{
+namespace db
+{
+/*!
+    \brief Connection observer that aggregates statement statistics per fingerprint
+    (similar to pg_stat_statements). Latencies are kept in histograms with power-of-two
+    bucket bounds in microseconds.
+*/
+class QueryStatistics : public ConnectionObserver
+{
+public:
+    using SPtr = std::shared_ptr<QueryStatistics>;
+
+    /*!
+        \brief The number of histogram buckets. Bucket i counts statements that took
+        at most 2^i microseconds, the last bucket counts all slower statements.
+    */
+    static constexpr std::size_t bucketCount = 26;
+
+    /*!
+        \brief Aggregated statistics of a single statement shape
+    */
+    struct Entry
+    {
+        std::uint64_t calls = 0;
+        std::uint64_t errors = 0;
+        std::uint64_t rows = 0;
+
+        StatementStats::Duration total{};
+        StatementStats::Duration min = StatementStats::Duration::max();
+        StatementStats::Duration max{};
+
+        StatementStats::Duration prepare{};
+        StatementStats::Duration execute{};
+        StatementStats::Duration fetch{};
+        StatementStats::Duration deserialize{};
+
+        std::array<std::uint64_t, bucketCount> histogram{};
+
+        /*!
+            \brief Estimates a percentile of the latency using the histogram
+            \param fraction a value in range [0, 1], e.g. 0.99 for p99
+            \return upper bound of the bucket the percentile falls into
+        */
+        StatementStats::Duration percentile(double fraction) const;
+    };
+
+    void onStatement(const StatementStats &stats) override;
+
+    /*!
+        \brief Returns a copy of the collected statistics
+        \return fingerprint -> statistics map
+    */
+    std::map<std::string, Entry> snapshot() const;
+
+    /*!
+        \brief Clears collected statistics
+    */
+    void reset();
+
+    /*!
+        \brief Dumps the collected statistics to JSON. Durations are in microseconds.
+        \return JSON document
+    */
+    std::string toJson() const;
+
+    /*!
+        \brief Returns the upper bound of the histogram bucket
+        \param bucket bucket index
+        \return the bound, Duration::max() for the last bucket
+    */
+    static StatementStats::Duration bucketBound(std::size_t bucket);
+
+private:
+    mutable std::mutex _mutex;
+    std::map<std::string, Entry> _entries;
+};
+
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_DBFACADE_QUERYSTATISTICS_H_
@@ -0,0 +1,143 @@
+#ifndef SOFTEQ_DBFACADE_RESULTCACHE_H_
+#define SOFTEQ_DBFACADE_RESULTCACHE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "tablecache.hh"
+
+namespace softeq
+{
+namespace db
+{
+/*!
+    \brief Cache of SELECT results attached to connections by Connection::setResultCache.
+    Results are keyed by the statement text and the bound values. Inserts, updates, removals, alterations
+    and drops performed through a connection using the cache invalidate the results which read the table
+    (as the main or a joined one). Results are bounded by the number of entries, their total size and their age.
+
+    The cache can't see changes made by other processes, triggers or foreign key cascades, the ttl bounds
+    how stale such results may get. invalidate() may be called for tables changed that way.
+
+    The cache is thread-safe and may be shared by connections to the same database.
+*/
+class ResultCache : public TableCache
+{
+public:
+    using SPtr = std::shared_ptr<ResultCache>;
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        std::size_t maxEntries = 1000;
+
+        /*!
+            \brief Total size of cached values in bytes. A result bigger than that is not cached.
+        */
+        std::size_t maxBytes = 16 * 1024 * 1024;
+
+        /*!
+            \brief Results older than that are not used
+        */
+        std::chrono::milliseconds ttl = std::chrono::seconds(10);
+    };
+
+    struct Counters
+    {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t invalidations = 0; //! entries removed because their tables changed
+        std::uint64_t evictions = 0;     //! entries removed because of the size limits or the ttl
+
+        /*!
+            \return the share of lookups served from the cache
+        */
+        double hitRate() const
+        {
+            return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses);
+        }
+    };
+
+    /*!
+        \brief A result as it is passed to Connection::parseFunc
+    */
+    struct Result
+    {
+        std::map<std::string, int> header;
+        std::vector<std::vector<std::string>> rows;
+        std::vector<std::vector<bool>> nulls;
+    };
+
+    ResultCache();
+    explicit ResultCache(const Options &options);
+
+    /*!
+        \brief Looks a result up
+        \param key the statement text and values
+        \return the result or nullptr
+    */
+    std::shared_ptr<const Result> find(const std::string &key);
+
+    /*!
+        \brief Returns a value to pass to store(). A result read after the call is stored only if no table
+        is invalidated in between, so a result read concurrently with a change is not cached.
+    */
+    std::uint64_t generation() const;
+
+    /*!
+        \brief Caches a result
+        \param key the statement text and values
+        \param tables tables the result is read from
+        \param result the result
+        \param generation the value of generation() taken before the result was read
+    */
+    void store(const std::string &key, const std::set<std::string> &tables, Result &&result,
+               std::uint64_t generation);
+
+    void invalidate(const std::string &table) override;
+    void invalidateOnCommit(const std::string &table) override;
+    void endTransaction() override;
+    void clear() override;
+
+    Counters counters() const;
+    void resetCounters();
+
+private:
+    struct Entry
+    {
+        std::string key;
+        std::set<std::string> tables;
+        std::shared_ptr<const Result> result;
+        std::size_t bytes = 0;
+        Clock::time_point stored;
+    };
+    using Entries = std::list<Entry>;
+
+    void invalidateLocked(const std::string &table);
+    void erase(Entries::iterator entry);
+
+    Options _options;
+
+    mutable std::mutex _mutex;
+    Entries _entries; // the most recently used first
+    std::unordered_map<std::string, Entries::iterator> _index;
+    std::map<std::string, std::set<std::string>> _tables; // table -> keys
+    std::map<std::thread::id, std::set<std::string>> _deferred;
+    std::size_t _bytes = 0;
+    std::uint64_t _generation = 0;
+    Counters _counters;
+};
+
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_DBFACADE_RESULTCACHE_H_
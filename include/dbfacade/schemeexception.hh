@@ -0,0 +1,43 @@
+#ifndef SOFTEQ_DBFACADE_SCHEMEEXCEPTION_H_
+#define SOFTEQ_DBFACADE_SCHEMEEXCEPTION_H_
+
+#include <vector>
+
+#include "sqlexception.hh"
+
+namespace softeq
+{
+namespace db
+{
+/*!
+    \brief Exception thrown when actual tables do not match their schemes. It carries all mismatches found.
+*/
+class SchemeException : public SqlException
+{
+public:
+    struct Mismatch
+    {
+        std::string table;
+        std::string message;
+    };
+
+    /*!
+        \brief Constructor
+        \param mismatches mismatches found, must not be empty.
+        If there is a single mismatch, the message of the exception is the message of the mismatch.
+    */
+    explicit SchemeException(const std::vector<Mismatch> &mismatches);
+
+    const std::vector<Mismatch> &mismatches() const
+    {
+        return _mismatches;
+    }
+
+private:
+    std::vector<Mismatch> _mismatches;
+};
+
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_DBFACADE_SCHEMEEXCEPTION_H_
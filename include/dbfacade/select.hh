@@ -5,6 +5,7 @@
 #include "orderby.hh"
 #include "resultlimit.hh"
 #include "join.hh"
+#include "fetchoptions.hh"
 
 namespace softeq
 {
@@ -77,10 +78,24 @@ public:
     */
     const ResultLimit &limits() const;
 
+    /*!
+        \brief The method sets the way rows are transferred from the database server, e.g.
+        select<T>({}).fetch(FetchOptions::streaming()) for large scans
+        \param[in] options the fetch options
+        \return this SelectQuery object with the fetch options set
+    */
+    SelectQuery &fetch(const FetchOptions &options);
+
+    /*!
+        \return FetchOptions object which describes how rows are transferred from the database server
+    */
+    const FetchOptions &fetchOptions() const;
+
 private:
     std::vector<Join> _joins;
     std::vector<OrderBy> _orderbys;
     ResultLimit _limit;
+    FetchOptions _fetchOptions;
 };
 
 namespace query
@@ -0,0 +1,96 @@
+#ifndef SOFTEQ_DBFACADE_SLOWQUERYLOG_H_
+#define SOFTEQ_DBFACADE_SLOWQUERYLOG_H_
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <mutex>
+
+#include "connection.hh"
+
+namespace softeq
+{
+namespace db
+{
+/*!
+    \brief Connection observer that records statements slower than a threshold together with their bound values
+    and the execution plan. Entries are kept in a bounded in-memory buffer and optionally appended to a file.
+*/
+class SlowQueryLog : public ConnectionObserver
+{
+public:
+    using SPtr = std::shared_ptr<SlowQueryLog>;
+
+    struct Options
+    {
+        /*!
+            \brief Statements that took at least this time are recorded
+        */
+        StatementStats::Duration threshold = std::chrono::milliseconds(100);
+
+        /*!
+            \brief Maximum number of entries kept in memory. The oldest entries are dropped first.
+        */
+        std::size_t capacity = 100;
+
+        /*!
+            \brief If not empty, entries are appended to this file as well
+        */
+        std::string filePath;
+
+        /*!
+            \brief Capture the execution plan of slow statements. It costs an extra round-trip per slow statement.
+        */
+        bool explain = true;
+    };
+
+    /*!
+        \brief A recorded statement
+    */
+    struct Entry
+    {
+        std::chrono::system_clock::time_point timestamp;
+        std::string sql;
+        std::vector<std::string> parameters;
+        StatementStats::Duration duration{};
+        std::string error;
+        QueryPlan plan;
+    };
+
+    /*!
+        \brief Constructor
+        \param connection the connection used to explain slow statements. Attaching the log to the connection
+        is up to the caller.
+        \param options log options
+    */
+    SlowQueryLog(const Connection::WPtr &connection, const Options &options);
+
+    void onStatement(const StatementStats &stats) override;
+
+    /*!
+        \brief Returns a copy of the recorded entries, the oldest first
+        \return entries
+    */
+    std::vector<Entry> entries() const;
+
+    /*!
+        \brief Drops recorded entries. The file is not touched.
+    */
+    void clear();
+
+private:
+    QueryPlan explain(const StatementStats &stats) const;
+    void write(const Entry &entry);
+
+    Connection::WPtr _connection;
+    Options _options;
+
+    mutable std::mutex _mutex;
+    std::deque<Entry> _entries;
+    std::ofstream _file;
+};
+
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_DBFACADE_SLOWQUERYLOG_H_
@@ -15,6 +15,13 @@ class SqlException : public std::runtime_error
 {
 public:
     explicit SqlException(const std::string &message);
+
+    /*!
+        \brief Checks if the error is transient (e.g. a lock conflict with another transaction),
+        so the transaction which failed may succeed if it is run again
+        \return true if running the transaction again makes sense
+    */
+    virtual bool retryable() const;
 };
 
 } // namespace db
@@ -1,6 +1,10 @@
 #ifndef SOFTEQ_DBFACADE_SQLITECONNECTION_H_
 #define SOFTEQ_DBFACADE_SQLITECONNECTION_H_
 
+#include <cstdint>
+#include <functional>
+#include <set>
+
 #include "connection.hh"
 
 struct sqlite3;
@@ -15,29 +19,145 @@ protected:
     std::string limit(const ResultLimit &query) const override;
 
 public:
-    explicit SqliteQueryStringBuilder(CellRepresentation &cellRepr);
+    /*!
+        \brief Constructor
+        \param cellRepr cell representation
+        \param sqliteVersion version of the Sqlite library in use (as sqlite3_libversion_number() returns it).
+        Some statements are built differently for older versions.
+    */
+    SqliteQueryStringBuilder(CellRepresentation &cellRepr, int sqliteVersion);
+
+    /*!
+        \brief Reads CREATE INDEX statements of the indexes created explicitly on a table
+    */
+    using IndexReader = std::function<std::vector<std::string>(const std::string &table)>;
 
+    /*!
+        \brief Sets the reader of indexes used to alter tables. Without it tables are altered as if they had
+        no indexes.
+        \param reader the reader
+    */
+    void setIndexReader(const IndexReader &reader);
+
+    /*!
+        \brief Builds statements to alter a table. Native ALTER TABLE DROP/RENAME COLUMN statements are used
+        when the Sqlite version supports them and the dropped columns are not keys, foreign keys or indexed.
+        Otherwise the table is rebuilt: a copy is created with full column definitions and foreign keys, the data
+        is copied to it and it replaces the original table. Indexes are created again with renamed columns,
+        indexes on dropped columns are dropped.
+        \param query the query
+        \return statements
+    */
     std::vector<Statement> buildStatement(const class AlterQuery &query) const override;
+
+private:
+    std::vector<Statement> rebuildTable(const class AlterQuery &query, const std::vector<std::string> &indexes) const;
+
+    int _sqliteVersion;
+    IndexReader _indexReader;
 };
 
 class SqliteConnection : public Connection
 {
 public:
+    /*!
+        \brief A row inserted, updated or removed, as the Sqlite update hook reports it
+    */
+    struct RowChange
+    {
+        enum class Operation
+        {
+            Insert,
+            Update,
+            Delete
+        };
+
+        Operation operation;
+        std::string table;
+        std::int64_t rowid;
+    };
+
+    /*!
+        \brief Receives the changes of the subscribed tables made by one committed transaction, in the order they
+        were made
+    */
+    using ChangeHandler = std::function<void(const std::vector<RowChange> &)>;
+    using SubscriptionId = std::uint64_t;
+
     explicit SqliteConnection(const std::string &dbName);
     ~SqliteConnection() override;
 
-    void verifyScheme(const TableScheme &) override;
+    QueryPlan explainStatement(const std::string &sql, const std::vector<SqlValue> &parameters) override;
+
+    /*!
+        \brief Subscribes to changes of a table made through the connection, including the ones made by triggers and
+        foreign key cascades. Changes are delivered once their transaction commits (a statement run outside a
+        transaction commits on its own), changes rolled back (to a savepoint as well) are dropped. The handler is called
+        on the thread which committed, after the commit statement, so it may query the database. Exceptions thrown by
+        the handler are ignored: the transaction has already committed and the other subscribers still get their
+        changes. Changes of WITHOUT ROWID tables are not reported by Sqlite, neither are rows removed by the REPLACE
+        conflict resolution (INSERT OR REPLACE) unless recursive triggers are on. While there are subscriptions, DELETE
+        without WHERE removes rows one by one instead of truncating the table, so they are reported.
+        \param table the table name
+        \param handler the handler
+        \return the id to pass to unsubscribe()
+    */
+    SubscriptionId subscribe(const std::string &table, const ChangeHandler &handler);
+
+    /*!
+        \brief Subscribes to changes of several tables. The changes of all of them made by a transaction are
+        delivered by a single call.
+        \param tables the table names
+        \param handler the handler
+        \return the id to pass to unsubscribe()
+    */
+    SubscriptionId subscribe(const std::set<std::string> &tables, const ChangeHandler &handler);
+
+    /*!
+        \brief Subscribes to changes of the table of a struct
+        \tparam Struct the type of the rows
+        \param handler the handler
+        \return the id to pass to unsubscribe()
+    */
+    template <typename Struct>
+    SubscriptionId subscribe(const ChangeHandler &handler)
+    {
+        return subscribe(buildTableScheme<Struct>().name(), handler);
+    }
+
+    void unsubscribe(SubscriptionId id);
 
 private:
+    std::vector<ColumnInfo> describeTables(const std::vector<std::string> &tables) override;
+    std::vector<std::string> describeIndexes(const std::string &table);
     void performImpl(const std::vector<Statement> &query, const parseFunc &) override;
     SqlQueryStringBuilder &queryBuilder() override;
     void enableForeignKeySupport();
     void enableWaitingOnBusy();
+    void enableChangeTracking();
+    void trackSavepoint(const std::string &sql);
+    void deliverChanges();
 
 private:
+    struct Subscription
+    {
+        std::set<std::string> tables;
+        ChangeHandler handler;
+    };
+
     sqlite3 *_db = nullptr;
     CellRepresentation _cellRepr;
-    SqliteQueryStringBuilder _builder{_cellRepr};
+    SqliteQueryStringBuilder _builder;
+
+    std::mutex _subscriptionsMutex;
+    std::map<SubscriptionId, Subscription> _subscriptions;
+    SubscriptionId _lastSubscription = 0;
+    std::atomic<bool> _subscribed{false};
+
+    // filled by the hooks, which run on the thread holding the connection
+    std::vector<RowChange> _pendingChanges;
+    std::vector<RowChange> _committedChanges;
+    std::vector<std::pair<std::string, std::size_t>> _savepoints; // name -> the number of pending changes
 };
 
 } // namespace db
@@ -13,6 +13,20 @@ public:
     explicit SqliteException(int errorCode);
     SqliteException(const std::string &message, int errorCode);
     SqliteException(const std::string &message, const std::string &query, int errorCode);
+
+    /*!
+        \return the sqlite result code
+    */
+    int errorCode() const;
+
+    /*!
+        \return true for SQLITE_BUSY and SQLITE_LOCKED. The busy handler of SqliteConnection waits for locks,
+        so SQLITE_BUSY means that waiting would deadlock (e.g. a read transaction can't upgrade to a write one).
+    */
+    bool retryable() const override;
+
+private:
+    int _errorCode;
 };
 
 } // namespace db
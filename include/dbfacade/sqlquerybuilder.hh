@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 #include <sstream>
 
 #include "sqlvalue.hh"
@@ -12,6 +13,7 @@
 #include "constraints.hh"
 #include "cellrepresentation.hh"
 #include "token.hh"
+#include "fetchoptions.hh"
 
 namespace softeq
 {
@@ -49,19 +51,52 @@ public:
     */
     std::string compose(const std::string &placeholderText = "?") const;
 
+    /*!
+        \brief Creates a string representation of a statement with values rendered in place. It is meant for
+        protocols that can't bind parameters, the renderer is responsible for escaping.
+        \param render a functor producing a literal for a value
+        \returns the string representation
+    */
+    std::string composeWithValues(const std::function<std::string(const SqlValue &)> &render) const;
+
     /*!
         \brief Returns a vector of SqlValue objects
         \returns a vector of SqlValue objects
     */
     std::vector<SqlValue> parameters() const;
 
+    /*!
+        \brief Sets the way the result of the statement is transferred from the server
+        \param options the fetch options
+    */
+    void setFetchOptions(const FetchOptions &options)
+    {
+        _fetchOptions = options;
+    }
+
+    const FetchOptions &fetchOptions() const
+    {
+        return _fetchOptions;
+    }
+
 private:
     std::vector<Token> _expression;
+    FetchOptions _fetchOptions;
+};
+
+/*!
+    \brief Limits of a single statement. Multi-row statements are split to fit them.
+*/
+struct StatementLimits
+{
+    std::size_t maxParameters = 999;  //! bound parameters per statement
+    std::size_t maxLength = 1000000; //! bytes of the statement text and bound values
 };
 
 class SqlQueryStringBuilder
 {
     CellRepresentation &_cellRepr;
+    StatementLimits _statementLimits;
 
 protected:
     /*!
@@ -70,14 +105,29 @@ protected:
         \param condition a condition
         \return a string representation for an SQL query string
     */
-    static std::vector<Token> where(const Condition &condition);
+    std::vector<Token> where(const Condition &condition) const;
 
     /*!
         \brief Conpose a string representation for 'JOIN' clause
         \param joins a vector of Join objects
         \return a string representation for an SQL query string
     */
-    static std::vector<Token> join(const std::vector<Join> &joins);
+    std::vector<Token> join(const std::vector<Join> &joins) const;
+
+    /*!
+        \brief Renders a list of values bound as one parameter (see Condition::inValues) as a subquery.
+        The default implementation uses the Sqlite json_each table-valued function.
+        \param list the list token, its value is a JSON array
+        \return tokens of the subquery
+    */
+    virtual std::vector<Token> valueList(const Token &list) const;
+
+    /*!
+        \brief Replaces list tokens of an expression by valueList()
+        \param tokens the expression
+        \return the expression to put into a statement
+    */
+    std::vector<Token> expandLists(const std::vector<Token> &tokens) const;
 
     /*!
         \brief Conpose a string representation for 'ORDER BY' clause
@@ -100,6 +150,13 @@ public:
     CellRepresentation &cellRepr() const;
     virtual ~SqlQueryStringBuilder();
 
+    /*!
+        \brief Sets limits of the connection the statements are built for
+        \param limits the limits
+    */
+    void setStatementLimits(const StatementLimits &limits);
+    const StatementLimits &statementLimits() const;
+
     virtual std::vector<Statement> buildStatement(const class CreateTableQuery &query) const;
     virtual std::vector<Statement> buildStatement(const class InsertQuery &query) const;
     virtual std::vector<Statement> buildStatement(const class SelectQuery &query) const;
@@ -110,8 +167,20 @@ public:
     virtual std::vector<Statement> buildStatement(const class BeginTransactionQuery &query) const;
     virtual std::vector<Statement> buildStatement(const class CommitTransactionQuery &query) const;
     virtual std::vector<Statement> buildStatement(const class RollbackTransactionQuery &query) const;
+    virtual std::vector<Statement> buildStatement(const class SavepointQuery &query) const;
+    virtual std::vector<Statement> buildStatement(const class ReleaseSavepointQuery &query) const;
+    virtual std::vector<Statement> buildStatement(const class RollbackToSavepointQuery &query) const;
 
     virtual std::string toString(const constraints::ForeignKeyConstraint &fk, const class TableScheme &scheme) const;
+
+    /*!
+        \brief Builds a foreign key constraint clause for a column which name may differ from the one in the scheme
+        (e.g. the column is being renamed)
+        \param fk the constraint
+        \param columnName name of the referencing column
+        \return the constraint clause
+    */
+    virtual std::string toString(const constraints::ForeignKeyConstraint &fk, const std::string &columnName) const;
 };
 
 } // namespace db
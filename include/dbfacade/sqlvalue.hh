@@ -73,6 +73,12 @@ private:
     Subtype _subtype = Subtype::String;
 };
 
+/*!
+    \brief Values are equal if they have the same subtype and content. NULLs are equal to each other.
+*/
+bool operator==(const SqlValue &lhs, const SqlValue &rhs);
+bool operator!=(const SqlValue &lhs, const SqlValue &rhs);
+
 } // namespace db
 } // namespace softeq
 
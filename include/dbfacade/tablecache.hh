@@ -0,0 +1,45 @@
+#ifndef SOFTEQ_DBFACADE_TABLECACHE_H_
+#define SOFTEQ_DBFACADE_TABLECACHE_H_
+
+#include <string>
+
+namespace softeq
+{
+namespace db
+{
+/*!
+    \brief Interface of caches which connections keep coherent with changes made through them
+*/
+class TableCache
+{
+public:
+    virtual ~TableCache() = default;
+
+    /*!
+        \brief Removes data read from the table
+        \param table the table name
+    */
+    virtual void invalidate(const std::string &table) = 0;
+
+    /*!
+        \brief Invalidates the table now and once more when the transaction of the calling thread ends (see
+        endTransaction), so data read by other sessions before the changes are committed is not kept.
+        \param table the table name
+    */
+    virtual void invalidateOnCommit(const std::string &table) = 0;
+
+    /*!
+        \brief Invalidates tables deferred by invalidateOnCommit() of the calling thread
+    */
+    virtual void endTransaction() = 0;
+
+    /*!
+        \brief Removes all data
+    */
+    virtual void clear() = 0;
+};
+
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_DBFACADE_TABLECACHE_H_
@@ -38,6 +38,21 @@ public:
     {
     }
 
+    /*!
+        \brief Constructs a token for a list of values bound as a single parameter (see Condition::inValues).
+        Query builders render it as a subquery reading the list, e.g. 'SELECT value FROM json_each(?)'.
+        \param encoded the values as a JSON array
+        \param elementType the type of the values
+        \return the token
+    */
+    static Token list(const SqlValue &encoded, SqlValue::Subtype elementType)
+    {
+        Token token(encoded);
+        token._isList = true;
+        token._listType = elementType;
+        return token;
+    }
+
     /*!
         \brief Extracts all values from a vector of tokens
         \param tokens a vector of tokens
@@ -72,10 +87,22 @@ public:
         return _value;
     }
 
+    bool isList() const
+    {
+        return _isList;
+    }
+
+    SqlValue::Subtype listType() const
+    {
+        return _listType;
+    }
+
 private:
     bool _isValue;
     std::string _text;
     SqlValue _value;
+    bool _isList = false;
+    SqlValue::Subtype _listType = SqlValue::Subtype::Empty;
 };
 
 /*!
@@ -8,13 +8,73 @@ namespace softeq
 {
 namespace db
 {
+/*!
+    \brief The struct describes how a transaction is started.
+    Backends ignore options they do not support: Sqlite transactions are always serializable and can't be
+    read-only, MySQL has no equivalent of the Sqlite locking behaviors.
+*/
+struct TransactionOptions
+{
+    /*!
+        \brief When Sqlite acquires the database lock
+    */
+    enum class Behavior
+    {
+        Deferred,  //! on the first access, a reader may fail to upgrade to a writer with SQLITE_BUSY
+        Immediate, //! the write lock is taken at once, other writers wait for it at BEGIN
+        Exclusive  //! no other connection can read or write until the end of the transaction
+    };
+
+    enum class Isolation
+    {
+        Default, //! the server default
+        ReadUncommitted,
+        ReadCommitted,
+        RepeatableRead,
+        Serializable
+    };
+
+    Behavior behavior = Behavior::Deferred;
+    Isolation isolation = Isolation::Default;
+    bool readOnly = false;
+
+    /*!
+        \brief Creates options of a transaction which is going to write, so it takes the write lock at once
+        \return the options
+    */
+    static TransactionOptions immediate()
+    {
+        TransactionOptions options;
+        options.behavior = Behavior::Immediate;
+        return options;
+    }
+
+    /*!
+        \brief Creates options of a transaction which only reads data
+        \param isolation the isolation level
+        \return the options
+    */
+    static TransactionOptions readOnlyWith(Isolation isolation = Isolation::Default)
+    {
+        TransactionOptions options;
+        options.isolation = isolation;
+        options.readOnly = true;
+        return options;
+    }
+};
+
 /*!
     \brief Class which represents a query which begins a transaction.
 */
 class BeginTransactionQuery : public SerializableSqlQuery<BeginTransactionQuery>
 {
 public:
-    explicit BeginTransactionQuery();
+    explicit BeginTransactionQuery(const TransactionOptions &options = TransactionOptions());
+
+    const TransactionOptions &options() const;
+
+private:
+    TransactionOptions _options;
 };
 
 /*!
@@ -35,6 +95,49 @@ public:
     explicit RollbackTransactionQuery();
 };
 
+/*!
+    \brief Class which represents a query which sets a savepoint inside a transaction.
+*/
+class SavepointQuery : public SerializableSqlQuery<SavepointQuery>
+{
+public:
+    explicit SavepointQuery(const std::string &name);
+
+    const std::string &name() const;
+
+private:
+    std::string _name;
+};
+
+/*!
+    \brief Class which represents a query which removes a savepoint keeping the changes made after it.
+*/
+class ReleaseSavepointQuery : public SerializableSqlQuery<ReleaseSavepointQuery>
+{
+public:
+    explicit ReleaseSavepointQuery(const std::string &name);
+
+    const std::string &name() const;
+
+private:
+    std::string _name;
+};
+
+/*!
+    \brief Class which represents a query which undoes the changes made after a savepoint.
+    The savepoint itself stays.
+*/
+class RollbackToSavepointQuery : public SerializableSqlQuery<RollbackToSavepointQuery>
+{
+public:
+    explicit RollbackToSavepointQuery(const std::string &name);
+
+    const std::string &name() const;
+
+private:
+    std::string _name;
+};
+
 namespace query
 {
 /*!
@@ -42,9 +145,9 @@ namespace query
     Do not use this method directly unless you have to. Prefer
     using db::Facade::execTransaction method
 */
-inline BeginTransactionQuery beginTransaction()
+inline BeginTransactionQuery beginTransaction(const TransactionOptions &options = TransactionOptions())
 {
-    return BeginTransactionQuery();
+    return BeginTransactionQuery(options);
 }
 
 /*!
@@ -65,6 +168,32 @@ inline RollbackTransactionQuery rollbackTransaction()
 {
     return RollbackTransactionQuery();
 }
+
+/*!
+    \brief Method forms a SAVEPOINT query.
+    Do not use this method directly unless you have to. Nested db::Facade::execTransaction calls
+    use savepoints.
+*/
+inline SavepointQuery savepoint(const std::string &name)
+{
+    return SavepointQuery(name);
+}
+
+/*!
+    \brief Method forms a RELEASE SAVEPOINT query.
+*/
+inline ReleaseSavepointQuery releaseSavepoint(const std::string &name)
+{
+    return ReleaseSavepointQuery(name);
+}
+
+/*!
+    \brief Method forms a ROLLBACK TO SAVEPOINT query.
+*/
+inline RollbackToSavepointQuery rollbackToSavepoint(const std::string &name)
+{
+    return RollbackToSavepointQuery(name);
+}
 } // namespace query
 
 } // namespace db
@@ -0,0 +1,97 @@
+#ifndef SOFTEQ_DBFACADE_TRANSACTIONRETRIER_H_
+#define SOFTEQ_DBFACADE_TRANSACTIONRETRIER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+
+#include "facade.hh"
+
+namespace softeq
+{
+namespace db
+{
+/*!
+    \brief Runs transactions again when they fail because of a conflict with concurrent ones
+    (SQLITE_BUSY, SQLITE_LOCKED, MySQL deadlocks and lock wait timeouts, see SqlException::retryable()).
+    Pauses between attempts grow exponentially and are randomized, so conflicting workers do not collide again.
+
+    The transaction function may be called several times, so it must not have side effects other than
+    database changes. A transaction nested into another one is not retried: its failure is passed to the outer
+    transaction, which is the one that has to be run again.
+
+    The retrier may be shared by threads.
+*/
+class TransactionRetrier
+{
+public:
+    struct Policy
+    {
+        /*!
+            \brief The maximum number of attempts including the first one
+        */
+        unsigned attempts = 5;
+
+        /*!
+            \brief The pause before the first retry, it is multiplied by multiplier for every next one
+        */
+        std::chrono::milliseconds initialBackoff{5};
+        std::chrono::milliseconds maxBackoff{500};
+        double multiplier = 2.0;
+
+        /*!
+            \brief The part of a pause which is random, in range [0, 1]
+        */
+        double jitter = 0.5;
+    };
+
+    struct Metrics
+    {
+        std::uint64_t transactions = 0; //! transactions run, each is counted once whatever the number of attempts
+        std::uint64_t retries = 0;      //! attempts made after a retryable failure
+        std::uint64_t exhausted = 0;    //! transactions that failed on the last attempt with a retryable error
+    };
+
+    TransactionRetrier();
+    explicit TransactionRetrier(const Policy &policy);
+
+    /*!
+        \brief Runs the function in a transaction by Facade::execTransaction
+        \param facade the facade
+        \param options options of the transaction
+        \param transactionFunction the function to execute, returns false to roll the transaction back
+        \throw SqlException if the transaction fails with an error that is not retryable or attempts are exhausted
+    */
+    void run(Facade &facade, const TransactionOptions &options,
+             const std::function<bool(Facade &)> &transactionFunction);
+
+    void run(Facade &facade, const std::function<bool(Facade &)> &transactionFunction)
+    {
+        run(facade, TransactionOptions(), transactionFunction);
+    }
+
+    /*!
+        \return the counters collected since the creation or the last reset
+    */
+    Metrics metrics() const;
+    void resetMetrics();
+
+private:
+    std::chrono::milliseconds backoff(unsigned retry);
+
+    Policy _policy;
+
+    std::atomic<std::uint64_t> _transactions{0};
+    std::atomic<std::uint64_t> _retries{0};
+    std::atomic<std::uint64_t> _exhausted{0};
+
+    std::mutex _randomMutex;
+    std::minstd_rand _random;
+};
+
+} // namespace db
+} // namespace softeq
+
+#endif // SOFTEQ_DBFACADE_TRANSACTIONRETRIER_H_
@@ -2,7 +2,9 @@
 #define SOFTEQ_DBFACADE_TYPESERIALIZERS_H_
 
 #include <cstdint>
+#include <cstdlib>
 #include <memory>
+#include <stdexcept>
 
 #include "typeconverter.hh"
 #include "typehint.hh"
@@ -62,10 +64,18 @@ struct serialize<Integral, typename std::enable_if<std::is_integral<Integral>::v
 
     static Integral to(const char* from)
     {
-        Integral num;
-        std::stringstream ss(from);
-        ss >> num;
-        return num;
+        if (from == nullptr)
+        {
+            throw std::invalid_argument("Can't convert NULL to an integer");
+        }
+
+        // strtoll/strtoull are much cheaper than std::stringstream. They also read 8-bit integers as numbers,
+        // not as characters.
+        if (std::is_signed<Integral>::value)
+        {
+            return static_cast<Integral>(std::strtoll(from, nullptr, 10));
+        }
+        return static_cast<Integral>(std::strtoull(from, nullptr, 10));
     }
 };
 
@@ -4,6 +4,8 @@
 #include "sqlquery.hh"
 #include "sqlexception.hh"
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 namespace softeq
 {
@@ -18,6 +20,117 @@ public:
     explicit UpdateQuery(const TableScheme &scheme);
 };
 
+/*!
+    \brief An entity together with the values its columns had when it was loaded. query::update of a tracked
+    entity writes only the columns changed since then.
+    \tparam <Struct> containing the schema of the database table
+*/
+template <typename Struct>
+class Tracked final
+{
+public:
+    /*!
+        \brief Takes the snapshot of the entity as it was read from the database
+    */
+    explicit Tracked(Struct entity)
+        : _entity(std::move(entity))
+    {
+        commit();
+    }
+
+    Struct &operator*()
+    {
+        return _entity;
+    }
+
+    const Struct &operator*() const
+    {
+        return _entity;
+    }
+
+    Struct *operator->()
+    {
+        return &_entity;
+    }
+
+    const Struct *operator->() const
+    {
+        return &_entity;
+    }
+
+    const Struct &get() const
+    {
+        return _entity;
+    }
+
+    /*!
+        \return the values of the scheme cells at the time of the snapshot, in the order of TableScheme::cells()
+    */
+    const std::vector<SqlValue> &snapshot() const
+    {
+        return _snapshot;
+    }
+
+    /*!
+        \return cells of the columns changed since the snapshot, serialized from the entity
+    */
+    std::vector<Cell> changedCells() const
+    {
+        std::vector<Cell> cells = buildTableScheme<Struct>().cells();
+        std::vector<Cell> changed;
+        for (std::size_t i = 0; i < cells.size(); ++i)
+        {
+            cells[i].serialize(_entity);
+            if (cells[i].value() != _snapshot[i])
+            {
+                changed.push_back(std::move(cells[i]));
+            }
+        }
+        return changed;
+    }
+
+    bool dirty() const
+    {
+        return !changedCells().empty();
+    }
+
+    /*!
+        \brief Takes a new snapshot, it should be called when the changes are written
+    */
+    void commit()
+    {
+        std::vector<Cell> cells = buildTableScheme<Struct>().cells();
+        _snapshot.clear();
+        _snapshot.reserve(cells.size());
+        for (Cell &cell : cells)
+        {
+            cell.serialize(_entity);
+            _snapshot.push_back(cell.value());
+        }
+    }
+
+private:
+    Struct _entity;
+    std::vector<SqlValue> _snapshot;
+};
+
+/*!
+    \brief Starts tracking rows read from the database
+    \param rows the rows
+    \return the tracked rows
+*/
+template <typename Struct>
+std::vector<Tracked<Struct>> track(std::vector<Struct> &&rows)
+{
+    std::vector<Tracked<Struct>> tracked;
+    tracked.reserve(rows.size());
+    for (Struct &row : rows)
+    {
+        tracked.emplace_back(std::move(row));
+    }
+    return tracked;
+}
+
 namespace query
 {
 /*!
@@ -85,6 +198,58 @@ UpdateQuery update(std::initializer_list<CellMaker> fields, const Struct &data)
     return query;
 }
 
+/*!
+    \brief Forms an UPDATE query writing only the columns of a tracked entity changed since its snapshot.
+    The row is searched by the primary key value of the snapshot, so a changed key is updated too.
+    \tparam <Struct> containing the schema of the database table
+    \param[in] data the tracked entity, its snapshot is not changed (call Tracked::commit when the query is executed)
+    \param[in] optimistic if true, the changed columns must still have the snapshot values, otherwise no row is
+    updated (Connection::changedRows() is 0, Facade::update reports it). Columns which were NULL are not checked.
+    \throw SqlException if nothing has changed or the table has no primary key
+*/
+template <typename Struct>
+UpdateQuery update(const Tracked<Struct> &data, bool optimistic = false)
+{
+    auto scheme = buildTableScheme<Struct>();
+    std::vector<Cell> cells = scheme.cells();
+    const std::vector<SqlValue> &snapshot = data.snapshot();
+
+    Condition where;
+    std::vector<Cell> changed;
+    for (std::size_t i = 0; i < cells.size(); ++i)
+    {
+        Cell &cell = cells[i];
+        cell.serialize(data.get());
+
+        const bool key = (cell.flags() & Cell::PRIMARY_KEY) != 0;
+        const bool dirty = cell.value() != snapshot[i];
+        if (key || (optimistic && dirty && snapshot[i].type() != SqlValue::Subtype::Null))
+        {
+            Condition match = (Condition(cell) == snapshot[i]);
+            where = where.hasValue() ? (where && match) : match;
+        }
+        if (dirty)
+        {
+            changed.push_back(std::move(cell));
+        }
+    }
+
+    if (changed.empty())
+    {
+        throw SqlException("no columns to update");
+    }
+    if (!where.hasValue())
+    {
+        throw SqlException("Tracked update of '" + scheme.name() + "' requires a primary key");
+    }
+
+    UpdateQuery query(scheme);
+    query.setCells(std::move(changed));
+    query.where(where);
+
+    return query;
+}
+
 } // namespace query
 
 } // namespace db
@@ -22,5 +22,31 @@ const TableScheme::DiffActionItems &AlterQuery::alters() const
     return _alters;
 }
 
+AlterQuery &AlterQuery::online(Algorithm algorithm, Lock lock)
+{
+    _algorithm = algorithm;
+    _lock = lock;
+    return *this;
+}
+
+AlterQuery::Algorithm AlterQuery::algorithm() const
+{
+    return _algorithm;
+}
+
+AlterQuery::Lock AlterQuery::lock() const
+{
+    return _lock;
+}
+
+AlterQuery AlterQuery::forTable(const std::string &table) const
+{
+    AlterQuery query(TableScheme(table, scheme().cells()));
+    query._alters = _alters;
+    query._algorithm = _algorithm;
+    query._lock = _lock;
+    return query;
+}
+
 } // namespace db
 } // namespace softeq
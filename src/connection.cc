@@ -0,0 +1,459 @@
+#include "connection.hh"
+#include "schemeexception.hh"
+#include "select.hh"
+#include "insert.hh"
+#include "update.hh"
+#include "remove.hh"
+#include "alter.hh"
+#include "drop.hh"
+#include "createtable.hh"
+#include "transaction.hh"
+
+#include <algorithm>
+
+namespace softeq
+{
+namespace db
+{
+void Connection::addObserver(const ConnectionObserver::SPtr &observer)
+{
+    std::lock_guard<std::mutex> lock(_observersMutex);
+
+    auto current = std::atomic_load(&_observers);
+    auto updated = current ? std::make_shared<Observers>(*current) : std::make_shared<Observers>();
+    updated->push_back(observer);
+
+    std::atomic_store(&_observers, std::shared_ptr<const Observers>(updated));
+    _observed.store(true, std::memory_order_relaxed);
+}
+
+void Connection::removeObserver(const ConnectionObserver::SPtr &observer)
+{
+    std::lock_guard<std::mutex> lock(_observersMutex);
+
+    auto current = std::atomic_load(&_observers);
+    if (!current)
+    {
+        return;
+    }
+    auto updated = std::make_shared<Observers>(*current);
+    updated->erase(std::remove(updated->begin(), updated->end(), observer), updated->end());
+
+    _observed.store(!updated->empty(), std::memory_order_relaxed);
+    std::atomic_store(&_observers, std::shared_ptr<const Observers>(updated));
+}
+
+std::size_t Connection::transactionDepth() const
+{
+    std::lock_guard<std::mutex> lock(_transactionsMutex);
+    auto depth = _transactionDepth.find(std::this_thread::get_id());
+    return depth == _transactionDepth.end() ? 0 : depth->second;
+}
+
+std::uint64_t Connection::changedRows() const
+{
+    std::lock_guard<std::mutex> lock(_transactionsMutex);
+    auto rows = _changedRows.find(std::this_thread::get_id());
+    return rows == _changedRows.end() ? 0 : rows->second;
+}
+
+void Connection::setChangedRows(std::uint64_t rows)
+{
+    std::lock_guard<std::mutex> lock(_transactionsMutex);
+    _changedRows[std::this_thread::get_id()] = rows;
+}
+
+std::size_t Connection::enterTransaction()
+{
+    std::lock_guard<std::mutex> lock(_transactionsMutex);
+    return _transactionDepth[std::this_thread::get_id()]++;
+}
+
+void Connection::leaveTransaction()
+{
+    std::lock_guard<std::mutex> lock(_transactionsMutex);
+    auto depth = _transactionDepth.find(std::this_thread::get_id());
+    if (depth != _transactionDepth.end() && --depth->second == 0)
+    {
+        _transactionDepth.erase(depth);
+    }
+}
+
+void Connection::performSplit(const SqlQuery &query, const std::vector<Statement> &statements, const parseFunc &fn)
+{
+    // a bulk insert split by the statement limits is as atomic as a single statement
+    if (transactionDepth() != 0 || !dynamic_cast<const InsertQuery *>(&query))
+    {
+        performStatements(query, statements, fn);
+        return;
+    }
+
+    enterTransaction();
+    try
+    {
+        perform(query::beginTransaction());
+        performStatements(query, statements, fn);
+        const std::uint64_t rows = changedRows();
+        perform(query::commitTransaction());
+        setChangedRows(rows);
+    }
+    catch (...)
+    {
+        try
+        {
+            perform(query::rollbackTransaction());
+        }
+        catch (const SqlException &)
+        {
+            // the original error is more important
+        }
+        leaveTransaction();
+        throw;
+    }
+    leaveTransaction();
+}
+
+namespace
+{
+/*!
+    \brief Builds a result cache key of statements
+    \param statements the statements
+    \return the key, empty if a result of the statements must not be cached
+*/
+std::string cacheKey(const std::vector<Statement> &statements)
+{
+    std::string key;
+    for (const Statement &statement : statements)
+    {
+        // streamed results are expected to be too big to keep
+        if (statement.fetchOptions().mode == FetchOptions::Mode::Streaming)
+        {
+            return std::string();
+        }
+
+        key += statement.compose();
+        for (const SqlValue &value : statement.parameters())
+        {
+            key += '\n';
+            key += std::to_string(static_cast<int>(value.type()));
+            key += ':';
+            key += value.toString();
+        }
+        key += '\0';
+    }
+    return key;
+}
+
+/*!
+    \brief Collects tables a SELECT query reads: the main one, joined ones and the ones of selected cells
+    \param query the query
+    \return table names
+*/
+std::set<std::string> readTables(const SelectQuery &query)
+{
+    std::set<std::string> tables{query.table()};
+    for (const Join &join : query.joins())
+    {
+        tables.insert(join.name());
+    }
+    for (const Cell &cell : query.cells())
+    {
+        if (!cell.tableName().empty())
+        {
+            tables.insert(cell.tableName());
+        }
+    }
+    return tables;
+}
+} // namespace
+
+void Connection::setResultCache(const ResultCache::SPtr &cache)
+{
+    std::atomic_store(&_resultCache, cache);
+    updateCached();
+}
+
+void Connection::setEntityCache(const EntityCache::SPtr &cache)
+{
+    std::atomic_store(&_entityCache, cache);
+    updateCached();
+}
+
+EntityCache::SPtr Connection::entityCache() const
+{
+    return std::atomic_load(&_entityCache);
+}
+
+void Connection::updateCached()
+{
+    _cached.store(std::atomic_load(&_resultCache) || std::atomic_load(&_entityCache), std::memory_order_relaxed);
+}
+
+void Connection::rowChanged(const std::string &table, std::int64_t rowid)
+{
+    auto cache = std::atomic_load(&_entityCache);
+    if (!cache)
+    {
+        return;
+    }
+    if (transactionDepth() != 0)
+    {
+        cache->invalidateOnCommit(table);
+    }
+    else
+    {
+        cache->invalidateRow(table, rowid);
+    }
+}
+
+void Connection::performCached(const SqlQuery &query, const std::vector<Statement> &statements, const parseFunc &fn)
+{
+    auto resultCache = std::atomic_load(&_resultCache);
+    const SelectQuery *select = dynamic_cast<const SelectQuery *>(&query);
+    if (select && resultCache)
+    {
+        ResultCache &cache = *resultCache;
+
+        // reads inside a transaction may see its own uncommitted changes
+        const std::string key = fn && transactionDepth() == 0 ? cacheKey(statements) : std::string();
+        if (key.empty())
+        {
+            performImpl(statements, fn);
+            return;
+        }
+
+        auto cached = cache.find(key);
+        if (cached)
+        {
+            std::vector<const char *> row;
+            for (std::size_t i = 0; i < cached->rows.size(); ++i)
+            {
+                row.clear();
+                for (std::size_t column = 0; column < cached->rows[i].size(); ++column)
+                {
+                    row.push_back(cached->nulls[i][column] ? nullptr : cached->rows[i][column].c_str());
+                }
+                fn(cached->header, row);
+            }
+            setChangedRows(0);
+            return;
+        }
+
+        const std::uint64_t generation = cache.generation();
+        ResultCache::Result result;
+        performImpl(statements, [&result, &fn](const std::map<std::string, int> &header,
+                                               const std::vector<const char *> &row) {
+            if (result.rows.empty())
+            {
+                result.header = header;
+            }
+            std::vector<std::string> values;
+            std::vector<bool> nulls;
+            for (const char *value : row)
+            {
+                values.emplace_back(value ? value : "");
+                nulls.push_back(value == nullptr);
+            }
+            result.rows.push_back(std::move(values));
+            result.nulls.push_back(std::move(nulls));
+            fn(header, row);
+        });
+        cache.store(key, readTables(*select), std::move(result), generation);
+        return;
+    }
+    if (select)
+    {
+        performImpl(statements, fn);
+        return;
+    }
+
+    // rows are cached after they are found, so inserts can't make them stale
+    const bool insert = dynamic_cast<const InsertQuery *>(&query) != nullptr;
+    std::vector<std::shared_ptr<TableCache>> caches;
+    if (resultCache)
+    {
+        caches.push_back(resultCache);
+    }
+    auto entityCache = std::atomic_load(&_entityCache);
+    if (entityCache && !insert)
+    {
+        caches.push_back(entityCache);
+    }
+
+    // caches are invalidated after the change, so data read concurrently is not stored (see generation())
+    std::function<void(TableCache &)> invalidate;
+    if (insert || dynamic_cast<const UpdateQuery *>(&query) ||
+        dynamic_cast<const RemoveQuery *>(&query) || dynamic_cast<const AlterQuery *>(&query) ||
+        dynamic_cast<const DropQuery *>(&query))
+    {
+        const bool inTransaction = transactionDepth() != 0;
+        invalidate = [inTransaction, &query](TableCache &cache) {
+            if (inTransaction)
+            {
+                cache.invalidateOnCommit(query.table());
+            }
+            else
+            {
+                cache.invalidate(query.table());
+            }
+        };
+    }
+    else if (dynamic_cast<const CommitTransactionQuery *>(&query) ||
+             dynamic_cast<const RollbackTransactionQuery *>(&query))
+    {
+        invalidate = [](TableCache &cache) { cache.endTransaction(); };
+    }
+    else if (!dynamic_cast<const CreateTableQuery *>(&query) && !dynamic_cast<const BeginTransactionQuery *>(&query) &&
+             !dynamic_cast<const SavepointQuery *>(&query) && !dynamic_cast<const ReleaseSavepointQuery *>(&query) &&
+             !dynamic_cast<const RollbackToSavepointQuery *>(&query))
+    {
+        // a custom query may change anything
+        invalidate = [](TableCache &cache) { cache.clear(); };
+    }
+
+    auto invalidateAll = [&caches, &invalidate]() {
+        if (invalidate)
+        {
+            for (const auto &cache : caches)
+            {
+                invalidate(*cache);
+            }
+        }
+    };
+    try
+    {
+        performImpl(statements, fn);
+    }
+    catch (...)
+    {
+        invalidateAll();
+        throw;
+    }
+    invalidateAll();
+}
+
+std::unique_lock<std::recursive_mutex> Connection::lease()
+{
+    return std::unique_lock<std::recursive_mutex>(_sessionMutex);
+}
+
+QueryPlan Connection::explain(const SqlQuery &query)
+{
+    auto lease = this->lease();
+    QueryPlan plan;
+    for (const Statement &statement : query.buildStatement(queryBuilder()))
+    {
+        auto statementPlan = explainStatement(statement.compose(), statement.parameters());
+        plan.steps.insert(plan.steps.end(), statementPlan.steps.begin(), statementPlan.steps.end());
+    }
+    return plan;
+}
+
+void Connection::verifySchemes(const std::vector<TableScheme> &schemes)
+{
+    auto lease = this->lease();
+    std::vector<std::string> tables;
+    for (const auto &scheme : schemes)
+    {
+        tables.push_back(scheme.name());
+    }
+
+    std::map<std::string, std::vector<ColumnInfo>> actualTables;
+    for (auto &column : describeTables(tables))
+    {
+        actualTables[column.table].push_back(std::move(column));
+    }
+
+    std::vector<SchemeException::Mismatch> mismatches;
+    for (const auto &scheme : schemes)
+    {
+        auto mismatch = [&mismatches, &scheme](const std::string &message) {
+            mismatches.push_back({scheme.name(), message});
+        };
+
+        auto actual = actualTables.find(scheme.name());
+        if (actual == actualTables.end())
+        {
+            mismatch("Table '" + scheme.name() + "' does not exist");
+            continue;
+        }
+
+        std::map<std::string, Cell> expectedCells;
+        for (auto &&cell : scheme.cells())
+        {
+            expectedCells[cell.name()] = std::move(cell);
+        }
+
+        for (const ColumnInfo &column : actual->second)
+        {
+            auto cellp = expectedCells.find(column.name);
+            if (cellp == std::end(expectedCells))
+            {
+                mismatch("Column '" + column.name + "' does not exist in the scheme");
+                continue;
+            }
+
+            const Cell &cell = cellp->second;
+            const std::string &name = column.name;
+
+            std::string expectedType = queryBuilder().cellRepr().type(cell.typeHash());
+            auto cellConfig = cell.config();
+            std::uint32_t flags = column.primaryKey ? static_cast<std::uint32_t>(Cell::PRIMARY_KEY) : 0u;
+
+            if (!sameType(column.type, expectedType))
+            {
+                mismatch("Type " + column.type + " of column '" + name + "' does not match type " + expectedType +
+                         " in scheme");
+            }
+            else if (!sameDefault(column.defaultValue, cellConfig))
+            {
+                mismatch("Default value '" + column.defaultValue + "' of column '" + name +
+                         "' does not match expected value " + cellConfig.toString());
+            }
+            else if (column.nullable != cell.isNullable()) // check changes for nullable flag
+            {
+                mismatch("The value of the nullable flag for column '" + name + "' has value (" +
+                         std::to_string(column.nullable) + ") and does not match expected (" +
+                         std::to_string(cell.isNullable()) + ")");
+            }
+            // NOTE: flag check does not check equivalence of flags, it check whether actual flags are included into
+            // expected ones. IMO it is more reasonable considering we can't get all flags.
+            // Moreover, probably PK should not be checked either since it can be set using constraints.
+            else if (column.primaryKey != !!(cell.flags() & Cell::PRIMARY_KEY)) // check only PRIMARY KEY
+            {
+                mismatch("Parameters (" + std::to_string(flags) + ") of column '" + name +
+                         "' do not match expected parameters (" + std::to_string(cell.flags()) + ")");
+            }
+
+            expectedCells.erase(cellp); // checked - erase
+        }
+
+        for (const auto &missing : expectedCells)
+        {
+            mismatch("Column '" + missing.first + "' from scheme does not exist in the table");
+        }
+    }
+
+    if (!mismatches.empty())
+    {
+        throw SchemeException(mismatches);
+    }
+}
+
+void Connection::notify(StatementStats &stats) const
+{
+    auto observers = std::atomic_load(&_observers);
+    if (!observers || observers->empty())
+    {
+        return;
+    }
+
+    stats.fingerprint = fingerprint(stats.sql);
+    for (const auto &observer : *observers)
+    {
+        observer->onStatement(stats);
+    }
+}
+
+} // namespace db
+} // namespace softeq
@@ -0,0 +1,59 @@
+#include "connectionobserver.hh"
+
+#include <cctype>
+
+namespace softeq
+{
+namespace db
+{
+std::string fingerprint(const std::string &sql)
+{
+    auto isIdentifierChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+
+    std::string result;
+    result.reserve(sql.size());
+
+    for (std::size_t i = 0; i < sql.size(); ++i)
+    {
+        char c = sql[i];
+        if (c == '\'')
+        {
+            // string literal, '' is an escaped quote
+            ++i;
+            while (i < sql.size() && !(sql[i] == '\'' && (i + 1 == sql.size() || sql[i + 1] != '\'')))
+            {
+                i += sql[i] == '\'' ? 2 : 1;
+            }
+            result += '?';
+        }
+        else if (std::isdigit(static_cast<unsigned char>(c)) && (result.empty() || !isIdentifierChar(result.back())))
+        {
+            // numeric literal (but not a part of an identifier like 'tmp_1')
+            while (i + 1 < sql.size() && (isIdentifierChar(sql[i + 1]) || sql[i + 1] == '.'))
+            {
+                ++i;
+            }
+            result += '?';
+        }
+        else if (std::isspace(static_cast<unsigned char>(c)))
+        {
+            if (!result.empty() && result.back() != ' ')
+            {
+                result += ' ';
+            }
+        }
+        else
+        {
+            result += c;
+        }
+    }
+
+    if (!result.empty() && result.back() == ' ')
+    {
+        result.pop_back();
+    }
+    return result;
+}
+
+} // namespace db
+} // namespace softeq
@@ -0,0 +1,200 @@
+#include "entitycache.hh"
+
+namespace softeq
+{
+namespace db
+{
+EntityCache::EntityCache()
+    : EntityCache(Options())
+{
+}
+
+EntityCache::EntityCache(const Options &options)
+    : _options(options)
+{
+}
+
+std::shared_ptr<const void> EntityCache::findEntry(const std::string &table, const SqlValue &key,
+                                                   std::type_index type)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto rows = _tables.find(table);
+    if (rows != _tables.end())
+    {
+        auto row = rows->second.rows.find(key.toString());
+        if (row != rows->second.rows.end() && row->second->type == type)
+        {
+            _entries.splice(_entries.begin(), _entries, row->second);
+            ++_counters.hits;
+            return row->second->entity;
+        }
+    }
+    ++_counters.misses;
+    return nullptr;
+}
+
+std::uint64_t EntityCache::generation() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _generation;
+}
+
+void EntityCache::storeEntry(const std::string &table, const SqlValue &key, std::shared_ptr<const void> &&entity,
+                             std::type_index type, std::size_t bytes, std::uint64_t generation)
+{
+    Entry entry;
+    entry.table = table;
+    entry.key = key.toString();
+    entry.entity = std::move(entity);
+    entry.type = type;
+    entry.bytes = bytes + table.size() + entry.key.size() + sizeof(Entry);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (generation != _generation || entry.bytes > _options.maxBytes || _options.maxEntries == 0)
+    {
+        return;
+    }
+
+    auto rows = _tables.find(table);
+    if (rows != _tables.end())
+    {
+        auto row = rows->second.rows.find(entry.key);
+        if (row != rows->second.rows.end())
+        {
+            erase(row->second);
+        }
+    }
+
+    while (!_entries.empty() &&
+           (_entries.size() >= _options.maxEntries || _bytes + entry.bytes > _options.maxBytes))
+    {
+        erase(std::prev(_entries.end()));
+        ++_counters.evictions;
+    }
+
+    _bytes += entry.bytes;
+    _entries.push_front(std::move(entry));
+
+    // erase() drops tables without rows, so the table is looked up after the evictions
+    Table &tableRows = _tables[table];
+    tableRows.integerKey = tableRows.integerKey && key.type() == SqlValue::Subtype::Integer;
+    tableRows.rows[_entries.front().key] = _entries.begin();
+}
+
+void EntityCache::invalidateRow(const std::string &table, std::int64_t rowid)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_generation;
+
+    auto rows = _tables.find(table);
+    if (rows == _tables.end())
+    {
+        return;
+    }
+    if (!rows->second.integerKey)
+    {
+        invalidateLocked(table);
+        return;
+    }
+
+    auto row = rows->second.rows.find(std::to_string(rowid));
+    if (row != rows->second.rows.end())
+    {
+        erase(row->second);
+        ++_counters.invalidations;
+    }
+}
+
+void EntityCache::invalidate(const std::string &table)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    invalidateLocked(table);
+}
+
+void EntityCache::invalidateOnCommit(const std::string &table)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    invalidateLocked(table);
+    _deferred[std::this_thread::get_id()].insert(table);
+}
+
+void EntityCache::endTransaction()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto deferred = _deferred.find(std::this_thread::get_id());
+    if (deferred == _deferred.end())
+    {
+        return;
+    }
+    for (const std::string &table : deferred->second)
+    {
+        invalidateLocked(table);
+    }
+    _deferred.erase(deferred);
+}
+
+void EntityCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_generation;
+    _counters.invalidations += _entries.size();
+    _entries.clear();
+    _tables.clear();
+    _bytes = 0;
+}
+
+EntityCache::Counters EntityCache::counters() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Counters counters = _counters;
+    counters.entries = _entries.size();
+    counters.bytes = _bytes;
+    return counters;
+}
+
+void EntityCache::resetCounters()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _counters = Counters();
+}
+
+void EntityCache::invalidateLocked(const std::string &table)
+{
+    ++_generation;
+
+    auto rows = _tables.find(table);
+    if (rows == _tables.end())
+    {
+        return;
+    }
+
+    // the whole table goes, so its entries are removed without erase()
+    std::unordered_map<std::string, Entries::iterator> stale;
+    stale.swap(rows->second.rows);
+    _tables.erase(rows);
+    for (const auto &row : stale)
+    {
+        _bytes -= row.second->bytes;
+        _entries.erase(row.second);
+        ++_counters.invalidations;
+    }
+}
+
+void EntityCache::erase(Entries::iterator entry)
+{
+    auto rows = _tables.find(entry->table);
+    if (rows != _tables.end())
+    {
+        rows->second.rows.erase(entry->key);
+        if (rows->second.rows.empty())
+        {
+            _tables.erase(rows);
+        }
+    }
+    _bytes -= entry->bytes;
+    _entries.erase(entry);
+}
+
+} // namespace db
+} // namespace softeq
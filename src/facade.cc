@@ -1,5 +1,10 @@
 #include "facade.hh"
 #include "transaction.hh"
+#include "constraints.hh"
+#include "remove.hh"
+#include "update.hh"
+
+#include <thread>
 
 namespace softeq
 {
@@ -10,28 +15,319 @@ void Facade::execute(const SqlQuery &query) const
     _connection->perform(query);
 }
 
-void Facade::beginTransaction()
+namespace
+{
+std::string savepointName(std::size_t depth)
 {
-    execute(query::beginTransaction());
+    return "sp_" + std::to_string(depth);
 }
+} // namespace
 
-void Facade::endTransaction(bool commit)
+void Facade::execTransaction(const TransactionOptions &options, std::function<bool(Facade &)> transactionFunction)
 {
-    if (commit)
+    // the transaction is rolled back by the destructor if the function throws
+    Transaction transaction(*this, options);
+    if (transactionFunction(*this))
     {
-        execute(query::commitTransaction());
+        transaction.commit();
     }
     else
     {
-        execute(query::rollbackTransaction());
+        transaction.rollback();
+    }
+}
+
+Cell Facade::primaryKey(const TableScheme &scheme)
+{
+    // cells() returns a copy, so the key is copied out of it
+    const TableScheme::Cells cells = scheme.cells();
+    const Cell *key = nullptr;
+    for (const Cell &cell : cells)
+    {
+        if (cell.flags() & Cell::PRIMARY_KEY)
+        {
+            if (key)
+            {
+                throw SqlException("Table '" + scheme.name() + "' has a composite primary key");
+            }
+            key = &cell;
+        }
+    }
+    if (!key)
+    {
+        throw SqlException("Table '" + scheme.name() + "' has no primary key");
+    }
+    return *key;
+}
+
+namespace
+{
+/*!
+    \brief Converts a key read as text back to a value to bind
+    \param key the key cell
+    \param text the text
+    \return the value
+*/
+SqlValue keyValue(const Cell &key, const char *text)
+{
+    if (!text)
+    {
+        return SqlValue::Null();
+    }
+    const std::size_t hash = key.typeHash();
+    if (hash == typeid(int).hash_code() || hash == typeid(std::int64_t).hash_code() ||
+        hash == typeid(std::int32_t).hash_code() || hash == typeid(std::uint32_t).hash_code())
+    {
+        return SqlValue(static_cast<std::int64_t>(std::stoll(text)));
+    }
+    return SqlValue(std::string(text));
+}
+
+Condition both(const Condition &lhs, const Condition &rhs)
+{
+    return lhs.hasValue() ? Condition{Operator::AND, lhs, rhs} : rhs;
+}
+} // namespace
+
+ChunkProgress Facade::executeInChunks(const SqlQuery &query, const ChunkOptions &options)
+{
+    if (auto remove = dynamic_cast<const RemoveQuery *>(&query))
+    {
+        return executeChunked(*remove, options);
+    }
+    if (auto update = dynamic_cast<const UpdateQuery *>(&query))
+    {
+        return executeChunked(*update, options);
+    }
+    throw SqlException("Only DELETE and UPDATE queries can be executed in chunks");
+}
+
+template <typename QueryT>
+ChunkProgress Facade::executeChunked(const QueryT &query, const ChunkOptions &options)
+{
+    if (options.chunkSize == 0)
+    {
+        throw SqlException("The chunk size must be positive");
+    }
+    if (transactionDepth() != 0)
+    {
+        // the chunks would be a part of the outer transaction and hold the lock until it ends
+        throw SqlException("Chunked execution can't be nested in a transaction");
+    }
+
+    const Cell key = primaryKey(query.scheme());
+    ChunkProgress progress;
+    SqlValue last;
+    while (true)
+    {
+        std::vector<SqlValue> keys;
+        {
+            Transaction transaction(*this, options.transaction);
+
+            // the rows up to the last key are processed, so the keys are read from it on
+            SelectQuery select(query.scheme());
+            select.setCells({key});
+            select.where(last.type() == SqlValue::Subtype::Empty ? query.condition()
+                                                                  : both(query.condition(), Condition(key) > last))
+                .orderBy(OrderBy(key))
+                .limit(options.chunkSize);
+            _connection->perform(select, [&key, &keys](const std::map<std::string, int> &,
+                                                       const std::vector<const char *> &row) {
+                keys.push_back(keyValue(key, row.front()));
+            });
+            if (keys.empty())
+            {
+                transaction.commit();
+                break;
+            }
+
+            QueryT chunk = query;
+            chunk.where(both(query.condition(), Condition(key).between(keys.front(), keys.back())));
+            execute(chunk);
+            transaction.commit();
+        }
+
+        ++progress.chunks;
+        progress.rows += keys.size();
+        last = keys.back();
+        if ((options.progress && !options.progress(progress)) || keys.size() < options.chunkSize)
+        {
+            break;
+        }
+        if (options.pause.count() > 0)
+        {
+            std::this_thread::sleep_for(options.pause);
+        }
+    }
+    return progress;
+}
+
+Cell Facade::foreignKey(const TableScheme &scheme, const Cell &referenced)
+{
+    std::vector<Cell> found;
+    for (const auto &constraint : scheme.constraints())
+    {
+        auto fk = std::dynamic_pointer_cast<constraints::ForeignKeyConstraint>(constraint);
+        if (fk && fk->foreignCell().tableName() == referenced.tableName() &&
+            fk->foreignCell().unqualifiedName() == referenced.unqualifiedName())
+        {
+            found.push_back(scheme.cell(fk->cell().offset()));
+            found.back().setTable(scheme.name());
+        }
+    }
+    if (found.empty())
+    {
+        throw SqlException("Table '" + scheme.name() + "' has no foreign key referencing '" + referenced.name() + "'");
+    }
+    if (found.size() > 1)
+    {
+        throw SqlException("Table '" + scheme.name() + "' has several foreign keys referencing '" + referenced.name() +
+                           "'");
+    }
+    return found.front();
+}
+
+Transaction Facade::transaction(const TransactionOptions &options)
+{
+    return Transaction(*this, options);
+}
+
+Transaction::Transaction(Facade &facade, const TransactionOptions &options)
+    : _connection(facade._connection)
+    , _lease(_connection->lease())
+    , _depth(_connection->enterTransaction())
+{
+    try
+    {
+        if (_depth == 0)
+        {
+            _connection->perform(query::beginTransaction(options));
+        }
+        else
+        {
+            _connection->perform(query::savepoint(savepointName(_depth)));
+        }
+    }
+    catch (...)
+    {
+        _connection->leaveTransaction();
+        throw;
+    }
+    _active = true;
+}
+
+Transaction::Transaction(Transaction &&other)
+    : _connection(std::move(other._connection))
+    , _lease(std::move(other._lease))
+    , _depth(other._depth)
+    , _active(other._active)
+{
+    other._active = false;
+}
+
+Transaction &Transaction::operator=(Transaction &&other)
+{
+    if (this != &other)
+    {
+        abort();
+        _connection = std::move(other._connection);
+        _lease = std::move(other._lease);
+        _depth = other._depth;
+        _active = other._active;
+        other._active = false;
+    }
+    return *this;
+}
+
+Transaction::~Transaction()
+{
+    abort();
+}
+
+void Transaction::commit()
+{
+    end(true);
+}
+
+void Transaction::rollback()
+{
+    end(false);
+}
+
+bool Transaction::active() const
+{
+    return _active;
+}
+
+void Transaction::end(bool commit)
+{
+    if (!_active)
+    {
+        throw SqlException("The transaction is not active");
+    }
+
+    try
+    {
+        if (_depth == 0)
+        {
+            if (commit)
+            {
+                _connection->perform(query::commitTransaction());
+            }
+            else
+            {
+                _connection->perform(query::rollbackTransaction());
+            }
+        }
+        else
+        {
+            if (!commit)
+            {
+                _connection->perform(query::rollbackToSavepoint(savepointName(_depth)));
+            }
+            _connection->perform(query::releaseSavepoint(savepointName(_depth)));
+        }
+    }
+    catch (...)
+    {
+        // e.g. COMMIT failed with SQLITE_BUSY, the transaction is still open
+        if (commit)
+        {
+            abort();
+        }
+        else
+        {
+            finish();
+        }
+        throw;
+    }
+    finish();
+}
+
+void Transaction::finish()
+{
+    _active = false;
+    _connection->leaveTransaction();
+    if (_lease.owns_lock())
+    {
+        _lease.unlock();
     }
 }
 
-void Facade::execTransaction(std::function<bool(Facade &)> transactionFunction)
+void Transaction::abort()
 {
-    beginTransaction();
-    bool commit = transactionFunction(*this);
-    endTransaction(commit);
+    if (!_active)
+    {
+        return;
+    }
+    try
+    {
+        end(false);
+    }
+    catch (const SqlException &)
+    {
+        // the original error is more important
+    }
 }
 
 } // namespace db
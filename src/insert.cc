@@ -10,5 +10,25 @@ InsertQuery::InsertQuery(const TableScheme &scheme)
 {
 }
 
+void InsertQuery::setRows(std::vector<std::vector<Cell>> &&rows)
+{
+    if (!rows.empty())
+    {
+        setCells(std::vector<Cell>(rows.front()));
+    }
+    _rows = std::move(rows);
+    _bulk = true;
+}
+
+const std::vector<std::vector<Cell>> &InsertQuery::rows() const
+{
+    return _rows;
+}
+
+bool InsertQuery::isBulk() const
+{
+    return _bulk;
+}
+
 } // namespace db
 } // namespace softeq
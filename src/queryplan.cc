@@ -0,0 +1,22 @@
+#include "queryplan.hh"
+
+namespace softeq
+{
+namespace db
+{
+std::string QueryPlan::toString() const
+{
+    std::string result;
+    for (const Step &step : steps)
+    {
+        if (!result.empty())
+        {
+            result += "\n";
+        }
+        result += step.detail;
+    }
+    return result;
+}
+
+} // namespace db
+} // namespace softeq
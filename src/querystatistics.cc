@@ -0,0 +1,173 @@
+#include "querystatistics.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+namespace softeq
+{
+namespace db
+{
+constexpr std::size_t QueryStatistics::bucketCount;
+
+namespace
+{
+/*!
+    \brief Escapes a string to be placed into a JSON document
+    \param text the string
+    \return quoted and escaped string
+*/
+std::string jsonString(const std::string &text)
+{
+    std::string result = "\"";
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '"':
+            result += "\\\"";
+            break;
+        case '\\':
+            result += "\\\\";
+            break;
+        case '\n':
+            result += "\\n";
+            break;
+        case '\t':
+            result += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buf[sizeof("\\u0000")];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                result += buf;
+            }
+            else
+            {
+                result += c;
+            }
+            break;
+        }
+    }
+    result += "\"";
+    return result;
+}
+
+std::int64_t microseconds(StatementStats::Duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+} // namespace
+
+StatementStats::Duration QueryStatistics::bucketBound(std::size_t bucket)
+{
+    if (bucket + 1 >= bucketCount)
+    {
+        return StatementStats::Duration::max();
+    }
+    return std::chrono::duration_cast<StatementStats::Duration>(std::chrono::microseconds(1ull << bucket));
+}
+
+StatementStats::Duration QueryStatistics::Entry::percentile(double fraction) const
+{
+    std::uint64_t count = 0;
+    for (auto bucketCalls : histogram)
+    {
+        count += bucketCalls;
+    }
+    if (count == 0)
+    {
+        return StatementStats::Duration::zero();
+    }
+
+    auto rank = static_cast<std::uint64_t>(fraction * count);
+    rank = std::max<std::uint64_t>(1, std::min(rank, count));
+
+    std::uint64_t accumulated = 0;
+    for (std::size_t i = 0; i < histogram.size(); ++i)
+    {
+        accumulated += histogram[i];
+        if (accumulated >= rank)
+        {
+            // the last bucket is not bounded, the max is the best estimation we have
+            return i + 1 == histogram.size() ? max : std::min(max, bucketBound(i));
+        }
+    }
+    return max;
+}
+
+void QueryStatistics::onStatement(const StatementStats &stats)
+{
+    auto total = stats.total();
+
+    std::size_t bucket = 0;
+    while (bucket + 1 < bucketCount && total > bucketBound(bucket))
+    {
+        ++bucket;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Entry &entry = _entries[stats.fingerprint];
+    ++entry.calls;
+    if (!stats.error.empty())
+    {
+        ++entry.errors;
+    }
+    entry.rows += stats.rows;
+    entry.total += total;
+    entry.min = std::min(entry.min, total);
+    entry.max = std::max(entry.max, total);
+    entry.prepare += stats.prepare;
+    entry.execute += stats.execute;
+    entry.fetch += stats.fetch;
+    entry.deserialize += stats.deserialize;
+    ++entry.histogram[bucket];
+}
+
+std::map<std::string, QueryStatistics::Entry> QueryStatistics::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _entries;
+}
+
+void QueryStatistics::reset()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+}
+
+std::string QueryStatistics::toJson() const
+{
+    auto entries = snapshot();
+
+    std::stringstream ss;
+    ss << "[";
+    for (auto iter = entries.begin(); iter != entries.end(); ++iter)
+    {
+        const Entry &entry = iter->second;
+        if (iter != entries.begin())
+        {
+            ss << ",";
+        }
+        ss << "{\"fingerprint\":" << jsonString(iter->first) << ",\"calls\":" << entry.calls
+           << ",\"errors\":" << entry.errors << ",\"rows\":" << entry.rows
+           << ",\"total_us\":" << microseconds(entry.total) << ",\"min_us\":" << microseconds(entry.min)
+           << ",\"max_us\":" << microseconds(entry.max) << ",\"p50_us\":" << microseconds(entry.percentile(0.5))
+           << ",\"p99_us\":" << microseconds(entry.percentile(0.99))
+           << ",\"prepare_us\":" << microseconds(entry.prepare) << ",\"execute_us\":" << microseconds(entry.execute)
+           << ",\"fetch_us\":" << microseconds(entry.fetch)
+           << ",\"deserialize_us\":" << microseconds(entry.deserialize) << ",\"histogram\":[";
+        for (std::size_t i = 0; i < entry.histogram.size(); ++i)
+        {
+            ss << (i ? "," : "") << entry.histogram[i];
+        }
+        ss << "]}";
+    }
+    ss << "]";
+    return ss.str();
+}
+
+} // namespace db
+} // namespace softeq
@@ -0,0 +1,190 @@
+#include "resultcache.hh"
+
+namespace softeq
+{
+namespace db
+{
+ResultCache::ResultCache()
+    : ResultCache(Options())
+{
+}
+
+ResultCache::ResultCache(const Options &options)
+    : _options(options)
+{
+}
+
+std::shared_ptr<const ResultCache::Result> ResultCache::find(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto found = _index.find(key);
+    if (found == _index.end())
+    {
+        ++_counters.misses;
+        return nullptr;
+    }
+
+    Entries::iterator entry = found->second;
+    if (Clock::now() - entry->stored >= _options.ttl)
+    {
+        erase(entry);
+        ++_counters.evictions;
+        ++_counters.misses;
+        return nullptr;
+    }
+
+    _entries.splice(_entries.begin(), _entries, entry);
+    ++_counters.hits;
+    return entry->result;
+}
+
+std::uint64_t ResultCache::generation() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _generation;
+}
+
+void ResultCache::store(const std::string &key, const std::set<std::string> &tables, Result &&result,
+                        std::uint64_t generation)
+{
+    std::size_t bytes = key.size();
+    for (const auto &row : result.rows)
+    {
+        for (const std::string &value : row)
+        {
+            bytes += value.size() + sizeof(value);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (generation != _generation || bytes > _options.maxBytes || _options.maxEntries == 0)
+    {
+        return;
+    }
+
+    auto found = _index.find(key);
+    if (found != _index.end())
+    {
+        erase(found->second);
+    }
+
+    while (!_entries.empty() && (_entries.size() >= _options.maxEntries || _bytes + bytes > _options.maxBytes))
+    {
+        erase(std::prev(_entries.end()));
+        ++_counters.evictions;
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.tables = tables;
+    entry.result = std::make_shared<const Result>(std::move(result));
+    entry.bytes = bytes;
+    entry.stored = Clock::now();
+    _entries.push_front(std::move(entry));
+
+    _index[key] = _entries.begin();
+    for (const std::string &table : tables)
+    {
+        _tables[table].insert(key);
+    }
+    _bytes += bytes;
+}
+
+void ResultCache::invalidate(const std::string &table)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    invalidateLocked(table);
+}
+
+void ResultCache::invalidateOnCommit(const std::string &table)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    invalidateLocked(table);
+    _deferred[std::this_thread::get_id()].insert(table);
+}
+
+void ResultCache::endTransaction()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto deferred = _deferred.find(std::this_thread::get_id());
+    if (deferred == _deferred.end())
+    {
+        return;
+    }
+    for (const std::string &table : deferred->second)
+    {
+        invalidateLocked(table);
+    }
+    _deferred.erase(deferred);
+}
+
+void ResultCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_generation;
+    _counters.invalidations += _entries.size();
+    _entries.clear();
+    _index.clear();
+    _tables.clear();
+    _bytes = 0;
+}
+
+ResultCache::Counters ResultCache::counters() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _counters;
+}
+
+void ResultCache::resetCounters()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _counters = Counters();
+}
+
+void ResultCache::invalidateLocked(const std::string &table)
+{
+    ++_generation;
+
+    auto keys = _tables.find(table);
+    if (keys == _tables.end())
+    {
+        return;
+    }
+
+    // erase() updates _tables, so the keys are taken out first
+    std::set<std::string> stale;
+    stale.swap(keys->second);
+    _tables.erase(keys);
+    for (const std::string &key : stale)
+    {
+        auto found = _index.find(key);
+        if (found != _index.end())
+        {
+            erase(found->second);
+            ++_counters.invalidations;
+        }
+    }
+}
+
+void ResultCache::erase(Entries::iterator entry)
+{
+    for (const std::string &table : entry->tables)
+    {
+        auto keys = _tables.find(table);
+        if (keys != _tables.end())
+        {
+            keys->second.erase(entry->key);
+            if (keys->second.empty())
+            {
+                _tables.erase(keys);
+            }
+        }
+    }
+    _bytes -= entry->bytes;
+    _index.erase(entry->key);
+    _entries.erase(entry);
+}
+
+} // namespace db
+} // namespace softeq
@@ -0,0 +1,32 @@
+#include "schemeexception.hh"
+
+namespace softeq
+{
+namespace db
+{
+namespace
+{
+std::string makeErrorMessage(const std::vector<SchemeException::Mismatch> &mismatches)
+{
+    if (mismatches.size() == 1)
+    {
+        return mismatches.front().message;
+    }
+
+    std::string what = std::to_string(mismatches.size()) + " scheme mismatches found:";
+    for (const auto &mismatch : mismatches)
+    {
+        what += "\n" + mismatch.table + ": " + mismatch.message;
+    }
+    return what;
+}
+} // namespace
+
+SchemeException::SchemeException(const std::vector<Mismatch> &mismatches)
+    : SqlException(makeErrorMessage(mismatches))
+    , _mismatches(mismatches)
+{
+}
+
+} // namespace db
+} // namespace softeq
@@ -39,6 +39,17 @@ const ResultLimit &SelectQuery::limits() const
     return _limit;
 }
 
+SelectQuery &SelectQuery::fetch(const FetchOptions &options)
+{
+    _fetchOptions = options;
+    return *this;
+}
+
+const FetchOptions &SelectQuery::fetchOptions() const
+{
+    return _fetchOptions;
+}
+
 const std::vector<OrderBy> &SelectQuery::orderBys() const
 {
     return _orderbys;
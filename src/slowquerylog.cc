@@ -0,0 +1,160 @@
+#include "slowquerylog.hh"
+
+#include <cctype>
+#include <ctime>
+
+namespace softeq
+{
+namespace db
+{
+namespace
+{
+/*!
+    \brief Checks if a statement can be explained. DDL and transaction control statements can't.
+    \param sql statement text
+    \return true for SELECT, INSERT, UPDATE, DELETE and WITH statements
+*/
+bool isExplainable(const std::string &sql)
+{
+    std::string keyword;
+    for (char c : sql)
+    {
+        if (std::isalpha(static_cast<unsigned char>(c)))
+        {
+            keyword += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+        else if (!keyword.empty() || !std::isspace(static_cast<unsigned char>(c)))
+        {
+            break;
+        }
+    }
+    return keyword == "SELECT" || keyword == "INSERT" || keyword == "UPDATE" || keyword == "DELETE" ||
+           keyword == "WITH";
+}
+} // namespace
+
+SlowQueryLog::SlowQueryLog(const Connection::WPtr &connection, const Options &options)
+    : _connection(connection)
+    , _options(options)
+{
+    if (!_options.filePath.empty())
+    {
+        _file.open(_options.filePath, std::ios::out | std::ios::app);
+        if (!_file)
+        {
+            throw SqlException("Failed to open slow query log file '" + _options.filePath + "'");
+        }
+    }
+}
+
+void SlowQueryLog::onStatement(const StatementStats &stats)
+{
+    auto duration = stats.total();
+    if (duration < _options.threshold)
+    {
+        return;
+    }
+
+    Entry entry;
+    entry.timestamp = std::chrono::system_clock::now();
+    entry.sql = stats.sql;
+    entry.duration = duration;
+    entry.error = stats.error;
+    if (stats.values)
+    {
+        for (const SqlValue &value : *stats.values)
+        {
+            entry.parameters.push_back(value.toString());
+        }
+    }
+    if (_options.explain && stats.error.empty())
+    {
+        entry.plan = explain(stats);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    write(entry);
+    if (_options.capacity == 0)
+    {
+        return;
+    }
+    if (_entries.size() == _options.capacity)
+    {
+        _entries.pop_front();
+    }
+    _entries.push_back(std::move(entry));
+}
+
+std::vector<SlowQueryLog::Entry> SlowQueryLog::entries() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return std::vector<Entry>(_entries.begin(), _entries.end());
+}
+
+void SlowQueryLog::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+}
+
+QueryPlan SlowQueryLog::explain(const StatementStats &stats) const
+{
+    auto connection = _connection.lock();
+    if (!connection || !isExplainable(stats.sql))
+    {
+        return QueryPlan();
+    }
+
+    try
+    {
+        return connection->explainStatement(stats.sql, stats.values ? *stats.values : std::vector<SqlValue>());
+    }
+    catch (const std::exception &e)
+    {
+        // the log must not break the application, an unexplained entry is still useful
+        QueryPlan plan;
+        QueryPlan::Step step;
+        step.detail = std::string("EXPLAIN failed: ") + e.what();
+        plan.steps.push_back(step);
+        return plan;
+    }
+}
+
+void SlowQueryLog::write(const Entry &entry)
+{
+    if (!_file.is_open())
+    {
+        return;
+    }
+
+    std::time_t time = std::chrono::system_clock::to_time_t(entry.timestamp);
+    std::tm tm{};
+    gmtime_r(&time, &tm);
+    char timestamp[sizeof("YYYY-MM-DDTHH:MM:SSZ")];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+    _file << "# Time: " << timestamp << "\n"
+          << "# Duration_us: " << std::chrono::duration_cast<std::chrono::microseconds>(entry.duration).count() << "\n";
+    if (!entry.parameters.empty())
+    {
+        _file << "# Parameters:";
+        for (const std::string &parameter : entry.parameters)
+        {
+            _file << " '" << parameter << "'";
+        }
+        _file << "\n";
+    }
+    if (!entry.error.empty())
+    {
+        _file << "# Error: " << entry.error << "\n";
+    }
+    for (const QueryPlan::Step &step : entry.plan.steps)
+    {
+        _file << "# Plan: " << step.detail << "\n";
+    }
+    _file << entry.sql << "\n";
+    _file.flush();
+}
+
+} // namespace db
+} // namespace softeq
@@ -11,5 +11,10 @@ SqlException::SqlException(const std::string &message)
 {
 }
 
+bool SqlException::retryable() const
+{
+    return false;
+}
+
 } // namespace db
 } // namespace softeq
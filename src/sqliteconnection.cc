@@ -2,21 +2,22 @@
 #include "sqliteexception.hh"
 #include "alter.hh"
 #include "select.hh"
+#include "constraints.hh"
 
 #include <sqlite3.h>
 #include <iostream>
 #include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iterator>
 #include <map>
+#include <set>
+#include <sstream>
 
 namespace softeq
 {
 namespace db
 {
-SqliteQueryStringBuilder::SqliteQueryStringBuilder(CellRepresentation &cellRepr)
-    : SqlQueryStringBuilder(cellRepr)
-{
-}
-
 std::string SqliteQueryStringBuilder::limit(const ResultLimit &limits) const
 {
     std::stringstream ss;
@@ -35,35 +36,248 @@ std::string SqliteQueryStringBuilder::limit(const ResultLimit &limits) const
     return ss.str();
 }
 
-std::vector<Statement> SqliteQueryStringBuilder::buildStatement(const class AlterQuery &query) const
+namespace
+{
+constexpr int renameColumnVersion = 3025000; // ALTER TABLE RENAME COLUMN is supported since 3.25.0
+constexpr int dropColumnVersion = 3035000;   // ALTER TABLE DROP COLUMN is supported since 3.35.0
+
+/*!
+    \brief Rewrites a CREATE INDEX statement for a table which is rebuilt
+    \param sql the statement as sqlite_master keeps it
+    \param table the name of the table after the rebuild
+    \param dropped columns dropped from the table
+    \param renamed columns renamed in the table (old name -> new name)
+    \return the statement or an empty string if the index refers to a dropped column
+*/
+std::string rewriteIndex(const std::string &sql, const std::string &table, const std::set<std::string> &dropped,
+                         const std::map<std::string, std::string> &renamed)
+{
+    auto lower = [](std::string name) {
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+        return name;
+    };
+
+    // identifiers before ON are the index name, the one after ON is the table, the rest refer to columns
+    // (or are keywords and function names, which never match column names as they must be quoted to be used so)
+    enum class Part
+    {
+        Index,
+        Table,
+        Columns
+    };
+    Part part = Part::Index;
+
+    std::string result;
+    std::size_t pos = 0;
+    while (pos < sql.size())
+    {
+        const char c = sql[pos];
+        if (c == '\'')
+        {
+            // string literals are copied as they are ('' is an escaped quote)
+            std::size_t end = pos + 1;
+            while (end < sql.size() && (sql[end] != '\'' || (end + 1 < sql.size() && sql[end + 1] == '\'')))
+            {
+                end += sql[end] == '\'' ? 2 : 1;
+            }
+            result.append(sql, pos, end + 1 - pos);
+            pos = end + 1;
+            continue;
+        }
+
+        std::string name;
+        const std::size_t start = pos;
+        bool quoted = false;
+        if (c == '"' || c == '`' || c == '[')
+        {
+            const char close = c == '[' ? ']' : c;
+            const std::size_t end = sql.find(close, pos + 1);
+            name = sql.substr(pos + 1, end == std::string::npos ? std::string::npos : end - pos - 1);
+            pos = end == std::string::npos ? sql.size() : end + 1;
+            quoted = true;
+        }
+        else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_')
+        {
+            while (pos < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[pos])) || sql[pos] == '_'))
+            {
+                ++pos;
+            }
+            name = sql.substr(start, pos - start);
+        }
+        else
+        {
+            result += c;
+            ++pos;
+            continue;
+        }
+
+        switch (part)
+        {
+        case Part::Index:
+            result.append(sql, start, pos - start);
+            if (!quoted && lower(name) == "on")
+            {
+                part = Part::Table;
+            }
+            break;
+        case Part::Table:
+            result += table;
+            part = Part::Columns;
+            break;
+        case Part::Columns:
+        {
+            const std::string column = lower(name);
+            for (const std::string &droppedColumn : dropped)
+            {
+                if (lower(droppedColumn) == column)
+                {
+                    return std::string();
+                }
+            }
+            auto rename = std::find_if(renamed.begin(), renamed.end(),
+                                       [&](const std::pair<const std::string, std::string> &item) {
+                                           return lower(item.first) == column;
+                                       });
+            if (rename != renamed.end())
+            {
+                result += rename->second;
+            }
+            else
+            {
+                result.append(sql, start, pos - start);
+            }
+            break;
+        }
+        }
+    }
+    return result;
+}
+
+/*!
+    \brief Checks if a column can be dropped by ALTER TABLE DROP COLUMN
+    \param cell the column
+    \param scheme the scheme of the table
+    \param indexes CREATE INDEX statements of the table
+    \return false if the column is a part of a key, a constraint or an index, Sqlite refuses to drop such columns
+*/
+bool canDropNatively(const Cell &cell, const TableScheme &scheme, const std::vector<std::string> &indexes)
+{
+    if (cell.flags() & (Cell::PRIMARY_KEY | Cell::UNIQUE))
+    {
+        return false;
+    }
+    for (const std::string &index : indexes)
+    {
+        if (rewriteIndex(index, scheme.name(), {cell.unqualifiedName()}, {}).empty())
+        {
+            return false;
+        }
+    }
+    for (const auto &constraint : scheme.constraints())
+    {
+        auto fk = std::dynamic_pointer_cast<constraints::ForeignKeyConstraint>(constraint);
+        if (fk && scheme.cell(fk->cell().offset()).unqualifiedName() == cell.unqualifiedName())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+    \brief Checks if a column can be added by ALTER TABLE ADD COLUMN
+    \param cell the column
+    \return false if the column is a key or is NOT NULL without a default value
+*/
+bool canAddNatively(const Cell &cell)
+{
+    if (cell.flags() & (Cell::PRIMARY_KEY | Cell::UNIQUE))
+    {
+        return false;
+    }
+    return cell.isNullable() || (cell.flags() & Cell::DEFAULT);
+}
+} // namespace
+
+SqliteQueryStringBuilder::SqliteQueryStringBuilder(CellRepresentation &cellRepr, int sqliteVersion)
+    : SqlQueryStringBuilder(cellRepr)
+    , _sqliteVersion(sqliteVersion)
+{
+}
+
+void SqliteQueryStringBuilder::setIndexReader(const IndexReader &reader)
 {
-    // Note: we may need to re-write this method after adding transactions
-    // because we use it here
+    _indexReader = reader;
+}
 
-    // Sqlite cannot drop columns, so we need to copy a table in order to alter table.
+std::vector<Statement> SqliteQueryStringBuilder::buildStatement(const class AlterQuery &query) const
+{
     const auto &alters = query.alters();
-    if (std::find_if(alters.begin(), alters.end(), [](const TableScheme::DiffActionItem &action) {
-            return action.type == TableScheme::DROP_COLUMN;
-        }) == alters.end())
+    // only dropped and renamed columns may need a rebuild, which has to recreate the indexes
+    const bool changesColumns =
+        std::any_of(alters.begin(), alters.end(), [](const TableScheme::DiffActionItem &action) {
+            return action.type == TableScheme::DROP_COLUMN || action.type == TableScheme::RENAME_COLUMN;
+        });
+    const std::vector<std::string> indexes =
+        changesColumns && _indexReader ? _indexReader(query.table()) : std::vector<std::string>();
+
+    bool native = true;
+    bool dropsColumns = false;
+    for (const auto &action : alters)
     {
-        // we do not need to drop columns
-        return SqlQueryStringBuilder::buildStatement(query);
+        if (action.type == TableScheme::DROP_COLUMN)
+        {
+            dropsColumns = true;
+            native = native && _sqliteVersion >= dropColumnVersion &&
+                     canDropNatively(action.cell, query.scheme(), indexes);
+        }
+        else if (action.type == TableScheme::RENAME_COLUMN)
+        {
+            native = native && _sqliteVersion >= renameColumnVersion;
+        }
     }
 
-    std::vector<Statement> ret;
+    // A NOT NULL column without default can't be added to a table with data. The rebuild makes such a column
+    // nullable, but we do it only when we have to rebuild because of dropped columns (as we always did before)
+    if (dropsColumns)
+    {
+        native = native && std::all_of(alters.begin(), alters.end(), [](const TableScheme::DiffActionItem &action) {
+                     return action.type != TableScheme::ADD_COLUMN || canAddNatively(action.cell);
+                 });
+    }
 
-    // probably creating a transaction is a nice thing since
-    // alter is not an atomic operation in sqlite
-    ret.emplace_back("BEGIN TRANSACTION;");
+    if (native)
+    {
+        return SqlQueryStringBuilder::buildStatement(query);
+    }
+    return rebuildTable(query, indexes);
+}
+
+std::vector<Statement> SqliteQueryStringBuilder::rebuildTable(const AlterQuery &query,
+                                                              const std::vector<std::string> &indexes) const
+{
+    // The table is rebuilt the way it is recommended by https://www.sqlite.org/lang_altertable.html:
+    // a new table is created with full column definitions, the data is copied and the tables are swapped.
+    std::vector<CellRepresentation::column_t> cols;    // columns of the new table
+    std::vector<std::string> srcNames;                 // columns to copy from the old table
+    std::vector<std::string> dstNames;                 // columns to copy to in the new table
+    std::map<std::string, std::string> renamedColumns; // old name -> new name
+    std::set<std::string> droppedColumns;
+
+    for (const auto &cell : query.cells())
+    {
+        auto col = cellRepr().column(cell);
+        col.name = col.alias;
+        cols.push_back(col);
+    }
 
-    // Create a copy of the table with field we need
-    std::stringstream statement;
-    statement << "CREATE TABLE tmp_" << query.table() << " AS SELECT ";
+    auto findColumn = [&cols](const std::string &name) {
+        return std::find_if(cols.begin(), cols.end(),
+                            [&name](const CellRepresentation::column_t &col) { return col.alias == name; });
+    };
 
-    // process alter operations
-    auto cols = cellRepr().columns(query.cells());
     auto newTableName = query.table();
-    for (const auto &action : alters)
+    for (const auto &action : query.alters())
     {
         switch (action.type)
         {
@@ -75,52 +289,114 @@ std::vector<Statement> SqliteQueryStringBuilder::buildStatement(const class Alte
         case TableScheme::ADD_COLUMN:
         {
             auto col = cellRepr().column(action.cell);
-            if (col.defval.type() == SqlValue::Subtype::Empty)
+            if (!action.cell.isNullable() && !(action.cell.flags() & Cell::DEFAULT))
             {
-                // it's a new column, it must have default
-                col.defval = SqlValue::Null();
+                // existing rows have no value for the column, so it can't be NOT NULL
+                constexpr const char *notNull = " NOT NULL";
+                auto pos = col.descr.find(notNull);
+                if (pos != std::string::npos)
+                {
+                    col.descr.erase(pos, std::strlen(notNull));
+                }
             }
+            col.name = col.alias;
             cols.push_back(col);
             break;
         }
         case TableScheme::DROP_COLUMN:
-            // if std::find_if returns cols.end(), it will mean we have messed up with calculating operations
-            cols.erase(std::find_if(cols.begin(), cols.end(), [&action](const CellRepresentation::column_t &col) {
-                return col.name == action.cell.unqualifiedName();
-            }));
+            // if findColumn returns cols.end(), it will mean we have messed up with calculating operations
+            cols.erase(findColumn(action.cell.unqualifiedName()));
+            droppedColumns.insert(action.cell.unqualifiedName());
             break;
         case TableScheme::RENAME_COLUMN:
         {
-            auto foundCol = std::find_if(cols.begin(), cols.end(), [&action](const CellRepresentation::column_t &col) {
-                return col.name == action.renameCell.first.unqualifiedName();
-            });
-            foundCol->alias = action.renameCell.second.unqualifiedName();
+            auto oldName = action.renameCell.first.unqualifiedName();
+            auto col = cellRepr().column(action.renameCell.second);
+            col.name = col.alias;
+            *findColumn(oldName) = col;
+
+            renamedColumns[oldName] = col.alias;
+            srcNames.push_back(oldName);
+            dstNames.push_back(col.alias);
             break;
         }
         }
     }
-    auto newFields = cellRepr().fieldsWithCasts(cols);
-    std::copy(newFields.begin(), std::prev(newFields.end()), std::ostream_iterator<std::string>(statement, ", "));
-    statement << *std::prev(newFields.end()) << " FROM " << query.table() << ";";
-    ret.emplace_back(statement.str());
 
-    // Drop the old table
-    statement = std::stringstream();
-    statement << "DROP TABLE " << query.table() << ";";
-    ret.emplace_back(statement.str());
+    for (const auto &cell : query.cells())
+    {
+        auto name = cell.unqualifiedName();
+        if (!droppedColumns.count(name) && !renamedColumns.count(name))
+        {
+            srcNames.push_back(name);
+            dstNames.push_back(name);
+        }
+    }
+
+    // constraints of the old table are recreated with renamed columns,
+    // constraints on dropped columns are dropped
+    std::vector<std::string> definitions;
+    for (const auto &col : cols)
+    {
+        definitions.push_back(col.name + " " + col.type + col.descr);
+    }
+    const auto &scheme = query.scheme();
+    for (const auto &constraint : scheme.constraints())
+    {
+        auto fk = std::dynamic_pointer_cast<constraints::ForeignKeyConstraint>(constraint);
+        if (!fk)
+        {
+            definitions.push_back(constraint->toString(*this, scheme));
+            continue;
+        }
+
+        auto columnName = scheme.cell(fk->cell().offset()).unqualifiedName();
+        if (droppedColumns.count(columnName))
+        {
+            continue;
+        }
+        auto renamed = renamedColumns.find(columnName);
+        definitions.push_back(toString(*fk, renamed != renamedColumns.end() ? renamed->second : columnName));
+    }
+
+    auto joined = [](const std::vector<std::string> &items) {
+        std::stringstream ss;
+        std::copy(items.begin(), std::prev(items.end()), std::ostream_iterator<std::string>(ss, ", "));
+        ss << items.back();
+        return ss.str();
+    };
+
+    std::vector<Statement> ret;
+
+    // alter is not an atomic operation in sqlite
+    ret.emplace_back("BEGIN TRANSACTION;");
+
+    ret.emplace_back("CREATE TABLE tmp_" + query.table() + " (" + joined(definitions) + ");");
+    if (!srcNames.empty())
+    {
+        ret.emplace_back("INSERT INTO tmp_" + query.table() + " (" + joined(dstNames) + ") SELECT " +
+                         joined(srcNames) + " FROM " + query.table() + ";");
+    }
+    ret.emplace_back("DROP TABLE " + query.table() + ";");
+    ret.emplace_back("ALTER TABLE tmp_" + query.table() + " RENAME TO " + newTableName + ";");
 
-    // Rename tmp_* to the original name
-    statement = std::stringstream();
-    statement << "ALTER TABLE tmp_" << query.table() << " RENAME TO " << newTableName << ";";
-    ret.emplace_back(statement.str());
+    // indexes are dropped with the old table, so they are created again on the new one
+    for (const std::string &index : indexes)
+    {
+        const std::string rewritten = rewriteIndex(index, newTableName, droppedColumns, renamedColumns);
+        if (!rewritten.empty())
+        {
+            ret.emplace_back(rewritten + ";");
+        }
+    }
 
-    // End transaction
     ret.emplace_back("COMMIT;");
 
     return ret;
 }
 
 SqliteConnection::SqliteConnection(const std::string &dbName)
+    : _builder(_cellRepr, sqlite3_libversion_number())
 {
     int ec = sqlite3_open(dbName.c_str(), &_db);
     if (ec != SQLITE_OK)
@@ -129,6 +405,13 @@ SqliteConnection::SqliteConnection(const std::string &dbName)
     }
     enableForeignKeySupport();
     enableWaitingOnBusy();
+    enableChangeTracking();
+
+    StatementLimits limits;
+    limits.maxParameters = sqlite3_limit(_db, SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+    limits.maxLength = sqlite3_limit(_db, SQLITE_LIMIT_SQL_LENGTH, -1);
+    _builder.setStatementLimits(limits);
+    _builder.setIndexReader([this](const std::string &table) { return describeIndexes(table); });
 }
 
 SqliteConnection::~SqliteConnection()
@@ -136,98 +419,63 @@ SqliteConnection::~SqliteConnection()
     sqlite3_close(_db);
 }
 
-void SqliteConnection::verifyScheme(const TableScheme &scheme)
+std::vector<Connection::ColumnInfo> SqliteConnection::describeTables(const std::vector<std::string> &tables)
 {
-    std::map<std::string, Cell> expectedCells;
-    for (auto &&cell : scheme.cells())
+    std::vector<ColumnInfo> columns;
+    if (tables.empty())
     {
-        expectedCells[cell.name()] = std::move(cell);
+        return columns;
     }
 
-    // Example of "PRAGMA table_info('tablename')" result:
-    // cid|name|type|notnull|dflt_value|pk
-    // 0|id|integer|1||1
-    // 1|name|text|0||0
-    auto processRow = [this, &expectedCells](const std::map<std::string, int> &header,
-                                             const std::vector<const char *> &row) {
+    // Example of the result:
+    // table_name|name|type|notnull|dflt_value|pk
+    // student|id|INTEGER|0||1
+    // student|name|TEXT|1||0
+    auto processRow = [&columns](const std::map<std::string, int> &header, const std::vector<const char *> &row) {
         auto fixNull = [](const char *ptr) { return ptr ? ptr : ""; };
 
-        constexpr const char *nameColumn = "name";
-        constexpr const char *typeColumn = "type";
-        constexpr const char *defaultColumn = "dflt_value";
-        constexpr const char *notnullColumn = "notnull";
-        constexpr const char *primarykeyColumn = "pk";
         constexpr const char *trueValue = "1";
+        constexpr const char *falseValue = "0";
+
+        ColumnInfo column;
+        column.table = fixNull(row[header.at("table_name")]);
+        column.name = fixNull(row[header.at("name")]);
+        column.type = fixNull(row[header.at("type")]);
+        column.defaultValue = fixNull(row[header.at("dflt_value")]);
+        column.nullable = std::string(fixNull(row[header.at("notnull")])) != trueValue;
+        column.primaryKey = std::string(fixNull(row[header.at("pk")])) != falseValue; // position in a composite PK
+        columns.push_back(std::move(column));
+    };
 
-        // info we get from actual (existing) table
-        const std::string name = fixNull(row[header.at(nameColumn)]);
-        const std::string type = fixNull(row[header.at(typeColumn)]);
-        const std::string defval = fixNull(row[header.at(defaultColumn)]);
-        const std::string isPK = fixNull(row[header.at(primarykeyColumn)]);
-        const std::string notNull = fixNull(row[header.at(notnullColumn)]);
-        std::uint32_t flags = 0;
-        bool isNullable = false;
-        if (notNull != trueValue)
-        {
-            isNullable = true;
-        }
-        if (isPK == trueValue)
-        {
-            flags |= Cell::PRIMARY_KEY;
-        }
-
-        auto cellp = expectedCells.find(name);
-        if (cellp == std::end(expectedCells))
-        {
-            throw SqlException("Column '" + name + "' does not exist in the scheme");
-        }
-
-        Cell &cell = cellp->second;
-
-        std::string expectedType = queryBuilder().cellRepr().type(cell.typeHash());
-        if (type != expectedType)
-        {
-            throw SqlException("Type " + type + " of column '" + name + "' does not match type " + expectedType +
-                               " in scheme");
-        }
-
-        auto cellConfig = cell.config();
-
-        if (defval != cellConfig.toString())
-        {
-            std::string exception = "Default value '" + defval + "' of column '" + name +
-                                    "' does not match expected value " + cellConfig.toString();
-
-            throw SqlException("Default value '" + defval + "' of column '" + name +
-                               "' does not match expected value " + cellConfig.toString());
-        }
-
-        if (isNullable != cell.isNullable()) // check changes for nullable flag
+    std::vector<Token> statement{Token("SELECT m.name AS table_name, p.name, p.type, p.\"notnull\", p.dflt_value, p.pk "
+                                       "FROM sqlite_master AS m JOIN pragma_table_info(m.name) AS p "
+                                       "WHERE m.type = 'table' AND m.name IN (")};
+    for (auto iter = tables.begin(); iter != tables.end(); ++iter)
+    {
+        if (iter != tables.begin())
         {
-            throw SqlException("The value of the nullable flag for column '" + name + "' has value (" +
-                               std::to_string(isNullable) + ") and does not match expected (" +
-                               std::to_string(cell.isNullable()) + ")");
+            statement.emplace_back(", ");
         }
+        statement.emplace_back(SqlValue(std::string(*iter)));
+    }
+    statement.emplace_back(") ORDER BY m.name, p.cid;");
 
-        // NOTE: flag check does not check equivalence of flags, it check whether actual flags are included into
-        // expected ones. IMO it is more reasonable considering we can't get all flags.
-        // Moreover, probably PK should not be checked either since it can be set using constraints.
-        bool pkCheck = (isPK == trueValue) == !!(cell.flags() & Cell::PRIMARY_KEY);
-        if (!pkCheck) // check only PRIMARY KEY
-        {
-            throw SqlException("Parameters (" + std::to_string(flags) + ") of column '" + name +
-                               "' do not match expected parameters (" + std::to_string(cell.flags()) + ")");
-        }
+    performImpl({Statement(std::move(statement))}, processRow);
+    return columns;
+}
 
-        expectedCells.erase(cellp); // checked - erase
+std::vector<std::string> SqliteConnection::describeIndexes(const std::string &table)
+{
+    std::vector<std::string> indexes;
+    auto processRow = [&indexes](const std::map<std::string, int> &header, const std::vector<const char *> &row) {
+        indexes.emplace_back(row[header.at("sql")]);
     };
 
-    performImpl({"PRAGMA table_info('" + scheme.name() + "');"}, processRow);
-
-    if (!expectedCells.empty())
-    {
-        throw SqlException("Column '" + std::begin(expectedCells)->first + "' from scheme does not exist in the table");
-    }
+    // indexes created for PRIMARY KEY and UNIQUE have no sql, the table definition creates them
+    std::vector<Token> statement{Token("SELECT sql FROM sqlite_master WHERE type = 'index' AND tbl_name = "),
+                                 Token(SqlValue(std::string(table))), Token(" AND sql IS NOT NULL ORDER BY name;")};
+    performImpl({Statement(std::move(statement))}, processRow);
+    return indexes;
 }
 
 namespace
@@ -254,10 +502,13 @@ std::map<std::string, int> header(sqlite3_stmt *stmt)
     \param statement Sqlite statement
     \param params a vector of SqlValue objects
     \param fn parse function
+    \param stats statistics to fill, nullptr if they are not collected
 */
 void executeSql(sqlite3 *db, const char *sql, const std::vector<SqlValue> &params,
-                const SqliteConnection::parseFunc &fn)
+                const SqliteConnection::parseFunc &fn, StatementStats *stats = nullptr)
 {
+    Stopwatch stopwatch(stats != nullptr);
+
     sqlite3_stmt *stmt = nullptr;
     int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
 
@@ -302,12 +553,24 @@ void executeSql(sqlite3 *db, const char *sql, const std::vector<SqlValue> &param
         throw SqliteException(sqlite3_errmsg(db), rc);
     }
 
+    if (stats)
+    {
+        stats->prepare = stopwatch.lap(); // including binding
+    }
+
     rc = SQLITE_ROW;
     std::map<std::string, int> columnsMap;
+    bool firstStep = true;
     while (rc == SQLITE_ROW)
     {
         std::vector<const char *> row;
         rc = sqlite3_step(stmt);
+        if (stats)
+        {
+            // the first step executes the statement, the rest fetch rows
+            (firstStep ? stats->execute : stats->fetch) += stopwatch.lap();
+            firstStep = false;
+        }
         if (rc == SQLITE_ROW)
         {
             if (columnsMap.empty())
@@ -323,6 +586,11 @@ void executeSql(sqlite3 *db, const char *sql, const std::vector<SqlValue> &param
             }
 
             fn(columnsMap, row);
+            if (stats)
+            {
+                stats->deserialize += stopwatch.lap();
+                ++stats->rows;
+            }
         }
     }
     if (rc != SQLITE_DONE)
@@ -334,10 +602,219 @@ void executeSql(sqlite3 *db, const char *sql, const std::vector<SqlValue> &param
 
 void SqliteConnection::performImpl(const std::vector<Statement> &statements, const parseFunc &fn)
 {
+    std::uint64_t changedRows = 0;
+    setChangedRows(changedRows);
     for (const Statement &statement : statements)
     {
-        executeSql(_db, statement.compose().c_str(), statement.parameters(), fn);
+        const int totalChanges = sqlite3_total_changes(_db);
+        const std::string sql = statement.compose();
+        const std::vector<SqlValue> parameters = statement.parameters();
+        try
+        {
+            observe(sql, parameters, [this, &sql, &parameters, &fn](StatementStats *stats) {
+                executeSql(_db, sql.c_str(), parameters, fn, stats);
+            });
+        }
+        catch (...)
+        {
+            // a failed COMMIT leaves the transaction open, so its changes may still be committed
+            _pendingChanges.insert(_pendingChanges.begin(), _committedChanges.begin(), _committedChanges.end());
+            _committedChanges.clear();
+            if (sqlite3_get_autocommit(_db))
+            {
+                _pendingChanges.clear();
+                _savepoints.clear();
+            }
+            throw;
+        }
+        // sqlite3_changes() keeps the count of the last data change, so it is read only if the statement was one
+        if (sqlite3_total_changes(_db) != totalChanges)
+        {
+            changedRows += sqlite3_changes(_db);
+        }
+        trackSavepoint(sql);
+        deliverChanges();
+    }
+    setChangedRows(changedRows);
+}
+
+SqliteConnection::SubscriptionId SqliteConnection::subscribe(const std::string &table, const ChangeHandler &handler)
+{
+    return subscribe(std::set<std::string>{table}, handler);
+}
+
+SqliteConnection::SubscriptionId SqliteConnection::subscribe(const std::set<std::string> &tables,
+                                                             const ChangeHandler &handler)
+{
+    std::lock_guard<std::mutex> lock(_subscriptionsMutex);
+    _subscriptions[++_lastSubscription] = Subscription{tables, handler};
+    _subscribed = true;
+    return _lastSubscription;
+}
+
+void SqliteConnection::unsubscribe(SubscriptionId id)
+{
+    std::lock_guard<std::mutex> lock(_subscriptionsMutex);
+    _subscriptions.erase(id);
+    _subscribed = !_subscriptions.empty();
+}
+
+void SqliteConnection::trackSavepoint(const std::string &sql)
+{
+    // the rollback hook is not called for ROLLBACK TO, so changes made after a savepoint are dropped here
+    auto savepointName = [&sql](const char *prefix) -> std::string {
+        if (sql.compare(0, std::strlen(prefix), prefix) != 0)
+        {
+            return std::string();
+        }
+        std::string name = sql.substr(std::strlen(prefix));
+        return name.substr(0, name.find_first_of("; "));
+    };
+    auto findSavepoint = [this](const std::string &name) {
+        auto found = std::find_if(_savepoints.rbegin(), _savepoints.rend(),
+                                  [&name](const std::pair<std::string, std::size_t> &savepoint) {
+                                      return savepoint.first == name;
+                                  });
+        return found == _savepoints.rend() ? _savepoints.end() : std::prev(found.base());
+    };
+
+    std::string name;
+    if (!(name = savepointName("SAVEPOINT ")).empty())
+    {
+        _savepoints.emplace_back(name, _pendingChanges.size());
+    }
+    else if (!(name = savepointName("RELEASE SAVEPOINT ")).empty())
+    {
+        _savepoints.erase(findSavepoint(name), _savepoints.end());
+    }
+    else if (!(name = savepointName("ROLLBACK TO SAVEPOINT ")).empty())
+    {
+        auto savepoint = findSavepoint(name);
+        if (savepoint != _savepoints.end())
+        {
+            // the savepoint stays after ROLLBACK TO
+            _pendingChanges.resize(std::min(_pendingChanges.size(), savepoint->second));
+            _savepoints.erase(std::next(savepoint), _savepoints.end());
+        }
+    }
+}
+
+void SqliteConnection::deliverChanges()
+{
+    if (_committedChanges.empty())
+    {
+        return;
+    }
+    // a handler may run queries which commit changes themselves
+    std::vector<RowChange> committed;
+    committed.swap(_committedChanges);
+
+    std::vector<std::pair<std::vector<RowChange>, ChangeHandler>> deliveries;
+    {
+        std::lock_guard<std::mutex> lock(_subscriptionsMutex);
+        for (const auto &subscription : _subscriptions)
+        {
+            std::vector<RowChange> changes;
+            std::copy_if(committed.begin(), committed.end(), std::back_inserter(changes),
+                         [&subscription](const RowChange &change) {
+                             return subscription.second.tables.count(change.table) != 0;
+                         });
+            if (!changes.empty())
+            {
+                deliveries.emplace_back(std::move(changes), subscription.second.handler);
+            }
+        }
+    }
+    // handlers are called without the lock, so they may subscribe and unsubscribe
+    for (const auto &delivery : deliveries)
+    {
+        try
+        {
+            delivery.second(delivery.first);
+        }
+        catch (...)
+        {
+            // the transaction is already committed, a failing handler must neither make the commit look failed
+            // (so it is retried) nor keep the other subscribers from their changes
+        }
+    }
+}
+
+namespace
+{
+/*!
+    \brief Converts a row of EXPLAIN QUERY PLAN result to a plan step
+    \param detail the 'detail' column, e.g. "SEARCH t USING INDEX idx (a=?)" or "USE TEMP B-TREE FOR ORDER BY"
+    \return the plan step
+*/
+QueryPlan::Step parsePlanDetail(const std::string &detail)
+{
+    QueryPlan::Step step;
+    step.detail = detail;
+
+    std::istringstream words(detail);
+    std::string operation;
+    words >> operation;
+
+    if (operation == "SCAN" || operation == "SEARCH")
+    {
+        words >> step.table;
+        if (step.table == "TABLE") // Sqlite before 3.36 reports "SCAN TABLE t"
+        {
+            words >> step.table;
+        }
+        step.fullScan = operation == "SCAN";
+
+        constexpr const char *integerPrimaryKey = "INTEGER PRIMARY KEY";
+        constexpr const char *automaticIndex = "AUTOMATIC";
+        constexpr const char *index = "INDEX ";
+
+        auto using_ = detail.find(" USING ");
+        if (using_ != std::string::npos)
+        {
+            if (detail.find(integerPrimaryKey, using_) != std::string::npos)
+            {
+                step.index = integerPrimaryKey;
+            }
+            else if (detail.find(automaticIndex, using_) != std::string::npos)
+            {
+                step.index = "AUTOMATIC INDEX";
+            }
+            else
+            {
+                auto indexPos = detail.find(index, using_);
+                if (indexPos != std::string::npos)
+                {
+                    std::istringstream(detail.substr(indexPos + std::strlen(index))) >> step.index;
+                }
+            }
+        }
+    }
+    else
+    {
+        constexpr const char *tempBTree = "USE TEMP B-TREE FOR ";
+        if (detail.compare(0, std::strlen(tempBTree), tempBTree) == 0)
+        {
+            step.temporary = detail.substr(std::strlen(tempBTree));
+        }
     }
+    return step;
+}
+} // namespace
+
+QueryPlan SqliteConnection::explainStatement(const std::string &sql, const std::vector<SqlValue> &parameters)
+{
+    QueryPlan plan;
+
+    // EXPLAIN QUERY PLAN result columns: id|parent|notused|detail
+    auto processRow = [&plan](const std::map<std::string, int> &header, const std::vector<const char *> &row) {
+        const char *detail = row[header.at("detail")];
+        plan.steps.push_back(parsePlanDetail(detail ? detail : ""));
+    };
+
+    // observers are not notified, so it is safe to call this method from an observer
+    executeSql(_db, ("EXPLAIN QUERY PLAN " + sql).c_str(), parameters, processRow);
+    return plan;
 }
 
 SqlQueryStringBuilder &SqliteConnection::queryBuilder()
@@ -358,5 +835,60 @@ void SqliteConnection::enableWaitingOnBusy()
         _db, [](void *, int) { return 1; }, nullptr);
 }
 
+void SqliteConnection::enableChangeTracking()
+{
+    // the hook sees rows changed by triggers and foreign key cascades as well
+    sqlite3_update_hook(
+        _db,
+        [](void *data, int operation, const char *, const char *table, sqlite3_int64 rowid) {
+            auto connection = static_cast<SqliteConnection *>(data);
+            connection->rowChanged(table, rowid);
+            if (connection->_subscribed)
+            {
+                RowChange change;
+                change.operation = operation == SQLITE_INSERT   ? RowChange::Operation::Insert
+                                   : operation == SQLITE_UPDATE ? RowChange::Operation::Update
+                                                                : RowChange::Operation::Delete;
+                change.table = table;
+                change.rowid = rowid;
+                connection->_pendingChanges.push_back(std::move(change));
+            }
+        },
+        this);
+
+    // DELETE without WHERE truncates the table without calling the update hook (if the table has no triggers and
+    // no foreign keys reference it). SQLITE_IGNORE for the DELETE action makes Sqlite remove the rows one by one,
+    // so subscribers see them. Statements are prepared for every execution, so the check is never stale.
+    sqlite3_set_authorizer(
+        _db,
+        [](void *data, int action, const char *, const char *, const char *, const char *) {
+            auto connection = static_cast<SqliteConnection *>(data);
+            return action == SQLITE_DELETE && connection->_subscribed ? SQLITE_IGNORE : SQLITE_OK;
+        },
+        this);
+
+    // the changes are delivered after the commit statement, Sqlite must not be used inside the hooks
+    sqlite3_commit_hook(
+        _db,
+        [](void *data) {
+            auto connection = static_cast<SqliteConnection *>(data);
+            connection->_committedChanges.insert(connection->_committedChanges.end(),
+                                                 connection->_pendingChanges.begin(),
+                                                 connection->_pendingChanges.end());
+            connection->_pendingChanges.clear();
+            connection->_savepoints.clear();
+            return 0;
+        },
+        this);
+    sqlite3_rollback_hook(
+        _db,
+        [](void *data) {
+            auto connection = static_cast<SqliteConnection *>(data);
+            connection->_pendingChanges.clear();
+            connection->_savepoints.clear();
+        },
+        this);
+}
+
 } // namespace db
 } // namespace softeq
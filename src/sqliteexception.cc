@@ -32,11 +32,13 @@ std::string makeErrorMessage(const std::string &message, int errorCode)
 
 SqliteException::SqliteException(const std::string &message, int errorCode)
 : db::SqlException(makeErrorMessage(message, errorCode))
+, _errorCode(errorCode)
 {
 }
 
 SqliteException::SqliteException(const std::string &message, const std::string &query, int errorCode)
 : db::SqlException(makeErrorMessage(message + " in '" + query + "'", errorCode))
+, _errorCode(errorCode)
 {
 }
 
@@ -45,5 +47,17 @@ SqliteException::SqliteException(int errorCode)
 {
 }
 
+int SqliteException::errorCode() const
+{
+    return _errorCode;
+}
+
+bool SqliteException::retryable() const
+{
+    // extended result codes keep the primary one in the lower byte
+    const int primary = _errorCode & 0xff;
+    return primary == SQLITE_BUSY || primary == SQLITE_LOCKED;
+}
+
 } // namespace db
 } // namespace softeq
@@ -50,6 +50,16 @@ std::string Statement::compose(const std::string &placeholderText) const
     return ss.str();
 }
 
+std::string Statement::composeWithValues(const std::function<std::string(const SqlValue &)> &render) const
+{
+    std::string result;
+    for (auto &token : _expression)
+    {
+        result += token.isValue() ? render(token.value()) : token.text();
+    }
+    return result;
+}
+
 std::vector<SqlValue> Statement::parameters() const
 {
     return Token::bindingParameters(_expression);
@@ -120,24 +130,34 @@ SqlQueryStringBuilder::~SqlQueryStringBuilder()
 {
 }
 
+void SqlQueryStringBuilder::setStatementLimits(const StatementLimits &limits)
+{
+    _statementLimits = limits;
+}
+
+const StatementLimits &SqlQueryStringBuilder::statementLimits() const
+{
+    return _statementLimits;
+}
+
 CellRepresentation &SqlQueryStringBuilder::cellRepr() const
 {
     return _cellRepr;
 }
 
-std::vector<Token> SqlQueryStringBuilder::where(const Condition &condition)
+std::vector<Token> SqlQueryStringBuilder::where(const Condition &condition) const
 {
     std::vector<Token> retval;
 
     if (condition.hasValue())
     {
-        retval << " WHERE " << condition.tokens();
+        retval << " WHERE " << expandLists(condition.tokens());
     }
 
     return retval;
 }
 
-std::vector<Token> SqlQueryStringBuilder::join(const std::vector<Join> &joins)
+std::vector<Token> SqlQueryStringBuilder::join(const std::vector<Join> &joins) const
 {
     std::vector<Token> tokens;
 
@@ -145,12 +165,36 @@ std::vector<Token> SqlQueryStringBuilder::join(const std::vector<Join> &joins)
     {
         for (const Join &join : joins)
         {
-            tokens << " JOIN " << join.tokens();
+            tokens << " JOIN " << expandLists(join.tokens());
         }
     }
     return tokens;
 }
 
+std::vector<Token> SqlQueryStringBuilder::valueList(const Token &list) const
+{
+    std::vector<Token> tokens;
+    tokens << "SELECT value FROM json_each(" << list.value() << ")";
+    return tokens;
+}
+
+std::vector<Token> SqlQueryStringBuilder::expandLists(const std::vector<Token> &tokens) const
+{
+    std::vector<Token> expanded;
+    for (const Token &token : tokens)
+    {
+        if (token.isList())
+        {
+            expanded << valueList(token);
+        }
+        else
+        {
+            expanded.push_back(token);
+        }
+    }
+    return expanded;
+}
+
 std::string SqlQueryStringBuilder::orderBy(const std::vector<OrderBy> &orderbys)
 {
     if (!orderbys.empty())
@@ -223,12 +267,64 @@ std::vector<Statement> SqlQueryStringBuilder::buildStatement(const class InsertQ
     std::vector<Token> tokens;
 
     auto shortNames = cellRepr().fieldsShortNames(query.cells());
-    auto values = cellRepr().values(query.cells());
 
-    tokens << "INSERT INTO " << query.table() << " (" << internal::join(shortNames, ", ") << ") VALUES ("
-           << internal::join(values, ", ") << ");";
+    if (!query.isBulk())
+    {
+        auto values = cellRepr().values(query.cells());
+
+        tokens << "INSERT INTO " << query.table() << " (" << internal::join(shortNames, ", ") << ") VALUES ("
+               << internal::join(values, ", ") << ");";
+
+        return {Statement{std::move(tokens)}};
+    }
+
+    // rows are packed into as few statements as the limits allow
+    std::vector<Statement> statements;
+    std::vector<Token> head;
+    head << "INSERT INTO " << query.table() << " (" << internal::join(shortNames, ", ") << ") VALUES ";
+    const std::size_t headLength = Statement(std::vector<Token>(head)).compose().size();
+    std::size_t parameters = 0;
+    std::size_t length = 0;
+    for (const std::vector<Cell> &row : query.rows())
+    {
+        auto values = cellRepr().values(row);
+
+        // placeholder, separator and the value itself
+        std::size_t rowLength = 4;
+        for (const SqlValue &value : values)
+        {
+            rowLength += value.toString().size() + 3;
+        }
 
-    return {Statement{std::move(tokens)}};
+        if (!tokens.empty() && (parameters + values.size() > statementLimits().maxParameters ||
+                                length + rowLength > statementLimits().maxLength))
+        {
+            tokens << ";";
+            statements.emplace_back(std::move(tokens));
+            tokens.clear();
+        }
+        if (tokens.empty())
+        {
+            tokens << head;
+            parameters = 0;
+            length = headLength;
+        }
+        else
+        {
+            tokens << ", ";
+        }
+
+        tokens << "(" << internal::join(values, ", ") << ")";
+        parameters += values.size();
+        length += rowLength;
+    }
+    if (!tokens.empty())
+    {
+        tokens << ";";
+        statements.emplace_back(std::move(tokens));
+    }
+
+    return statements;
 }
 
 std::vector<Statement> SqlQueryStringBuilder::buildStatement(const class SelectQuery &query) const
@@ -239,7 +335,9 @@ std::vector<Statement> SqlQueryStringBuilder::buildStatement(const class SelectQ
     sql << "SELECT " << internal::join(selectFields, ", ", "*") << " FROM " << query.table() << join(query.joins())
         << where(query.condition()) << orderBy(query.orderBys()) << limit(query.limits()) << ";";
 
-    return {Statement{std::move(sql)}};
+    Statement statement{std::move(sql)};
+    statement.setFetchOptions(query.fetchOptions());
+    return {statement};
 }
 
 std::vector<Statement> SqlQueryStringBuilder::buildStatement(const class RemoveQuery &query) const
@@ -333,9 +431,17 @@ std::vector<Statement> SqlQueryStringBuilder::buildStatement(const class AlterQu
     return statements;
 }
 
-std::vector<Statement> SqlQueryStringBuilder::buildStatement(const class BeginTransactionQuery &) const
+std::vector<Statement> SqlQueryStringBuilder::buildStatement(const class BeginTransactionQuery &query) const
 {
-    return std::vector<Statement>{"BEGIN TRANSACTION;"};
+    switch (query.options().behavior)
+    {
+    case TransactionOptions::Behavior::Immediate:
+        return std::vector<Statement>{"BEGIN IMMEDIATE TRANSACTION;"};
+    case TransactionOptions::Behavior::Exclusive:
+        return std::vector<Statement>{"BEGIN EXCLUSIVE TRANSACTION;"};
+    default:
+        return std::vector<Statement>{"BEGIN TRANSACTION;"};
+    }
 }
 
 std::vector<Statement> SqlQueryStringBuilder::buildStatement(const class CommitTransactionQuery &) const
@@ -348,12 +454,33 @@ std::vector<Statement> SqlQueryStringBuilder::buildStatement(const class Rollbac
     return std::vector<Statement>{"ROLLBACK;"};
 }
 
+std::vector<Statement> SqlQueryStringBuilder::buildStatement(const class SavepointQuery &query) const
+{
+    return std::vector<Statement>{"SAVEPOINT " + query.name() + ";"};
+}
+
+std::vector<Statement> SqlQueryStringBuilder::buildStatement(const class ReleaseSavepointQuery &query) const
+{
+    return std::vector<Statement>{"RELEASE SAVEPOINT " + query.name() + ";"};
+}
+
+std::vector<Statement> SqlQueryStringBuilder::buildStatement(const class RollbackToSavepointQuery &query) const
+{
+    return std::vector<Statement>{"ROLLBACK TO SAVEPOINT " + query.name() + ";"};
+}
+
 // TODO: this method is called toString but relevant for constraints only. Probably worth renaming
 std::string SqlQueryStringBuilder::toString(const class constraints::ForeignKeyConstraint &fk,
                                             const class TableScheme &scheme) const
+{
+    return toString(fk, scheme.cell(fk.cell().offset()).unqualifiedName());
+}
+
+std::string SqlQueryStringBuilder::toString(const class constraints::ForeignKeyConstraint &fk,
+                                            const std::string &columnName) const
 {
     std::stringstream ss;
-    ss << "FOREIGN KEY ( " << scheme.cell(fk.cell().offset()).unqualifiedName() << " ) REFERENCES "
+    ss << "FOREIGN KEY ( " << columnName << " ) REFERENCES "
        << fk.foreignCell().tableName() << " ( " << fk.foreignCell().unqualifiedName() << " ) ";
     for (const auto &trigger : fk.triggers())
     {
@@ -29,5 +29,30 @@ std::string SqlValue::toString() const
         return _value;
     }
 }
+
+bool operator==(const SqlValue &lhs, const SqlValue &rhs)
+{
+    if (lhs.type() != rhs.type())
+    {
+        return false;
+    }
+    switch (lhs.type())
+    {
+    case SqlValue::Subtype::Integer:
+        return lhs.intValue() == rhs.intValue();
+
+    case SqlValue::Subtype::Null:
+    case SqlValue::Subtype::Empty:
+        return true;
+
+    default:
+        return lhs.strValue() == rhs.strValue();
+    }
+}
+
+bool operator!=(const SqlValue &lhs, const SqlValue &rhs)
+{
+    return !(lhs == rhs);
+}
 } // namespace db
 } // namespace softeq
@@ -4,11 +4,17 @@ namespace softeq
 {
 namespace db
 {
-BeginTransactionQuery::BeginTransactionQuery()
+BeginTransactionQuery::BeginTransactionQuery(const TransactionOptions &options)
     : SerializableSqlQuery(TableScheme{})
+    , _options(options)
 {
 }
 
+const TransactionOptions &BeginTransactionQuery::options() const
+{
+    return _options;
+}
+
 CommitTransactionQuery::CommitTransactionQuery()
     : SerializableSqlQuery(TableScheme{})
 {
@@ -19,5 +25,38 @@ RollbackTransactionQuery::RollbackTransactionQuery()
 {
 }
 
+SavepointQuery::SavepointQuery(const std::string &name)
+    : SerializableSqlQuery(TableScheme{})
+    , _name(name)
+{
+}
+
+const std::string &SavepointQuery::name() const
+{
+    return _name;
+}
+
+ReleaseSavepointQuery::ReleaseSavepointQuery(const std::string &name)
+    : SerializableSqlQuery(TableScheme{})
+    , _name(name)
+{
+}
+
+const std::string &ReleaseSavepointQuery::name() const
+{
+    return _name;
+}
+
+RollbackToSavepointQuery::RollbackToSavepointQuery(const std::string &name)
+    : SerializableSqlQuery(TableScheme{})
+    , _name(name)
+{
+}
+
+const std::string &RollbackToSavepointQuery::name() const
+{
+    return _name;
+}
+
 } // namespace db
 } // namespace softeq
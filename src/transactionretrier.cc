@@ -0,0 +1,96 @@
+#include "transactionretrier.hh"
+
+#include <algorithm>
+#include <thread>
+
+namespace softeq
+{
+namespace db
+{
+TransactionRetrier::TransactionRetrier()
+    : TransactionRetrier(Policy())
+{
+}
+
+TransactionRetrier::TransactionRetrier(const Policy &policy)
+    : _policy(policy)
+    , _random(std::random_device()())
+{
+    if (_policy.attempts == 0)
+    {
+        throw SqlException("At least one attempt is required");
+    }
+}
+
+void TransactionRetrier::run(Facade &facade, const TransactionOptions &options,
+                             const std::function<bool(Facade &)> &transactionFunction)
+{
+    const bool nested = facade.transactionDepth() != 0;
+    if (!nested)
+    {
+        ++_transactions;
+    }
+
+    for (unsigned attempt = 1;; ++attempt)
+    {
+        try
+        {
+            facade.execTransaction(options, transactionFunction);
+            return;
+        }
+        catch (const SqlException &e)
+        {
+            if (nested || !e.retryable())
+            {
+                throw;
+            }
+            if (attempt == _policy.attempts)
+            {
+                ++_exhausted;
+                throw;
+            }
+        }
+
+        ++_retries;
+        std::this_thread::sleep_for(backoff(attempt));
+    }
+}
+
+TransactionRetrier::Metrics TransactionRetrier::metrics() const
+{
+    Metrics metrics;
+    metrics.transactions = _transactions.load();
+    metrics.retries = _retries.load();
+    metrics.exhausted = _exhausted.load();
+    return metrics;
+}
+
+void TransactionRetrier::resetMetrics()
+{
+    _transactions = 0;
+    _retries = 0;
+    _exhausted = 0;
+}
+
+std::chrono::milliseconds TransactionRetrier::backoff(unsigned retry)
+{
+    double pause = static_cast<double>(_policy.initialBackoff.count());
+    for (unsigned i = 1; i < retry && pause < _policy.maxBackoff.count(); ++i)
+    {
+        pause *= _policy.multiplier;
+    }
+    pause = std::min(pause, static_cast<double>(_policy.maxBackoff.count()));
+
+    const double jitter = std::max(0.0, std::min(_policy.jitter, 1.0));
+    double random = 0;
+    {
+        std::lock_guard<std::mutex> lock(_randomMutex);
+        random = std::uniform_real_distribution<double>(0.0, 1.0)(_random);
+    }
+
+    // up to the jitter share of the pause is randomly taken off
+    return std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(pause * (1.0 - jitter * random)));
+}
+
+} // namespace db
+} // namespace softeq
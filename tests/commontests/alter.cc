@@ -2,6 +2,8 @@
 #include <dbfacade/alter.hh>
 #include <dbfacade/insert.hh>
 #include <dbfacade/select.hh>
+#include <dbfacade/sqliteconnection.hh>
+#include <sqlite3.h>
 
 using namespace softeq;
 
@@ -113,6 +115,84 @@ const db::TableScheme db::buildTableScheme<DoubleKeyStudent>()
     return scheme;
 }
 
+struct KeyedStudent
+{
+    int id;
+    std::string code;
+    int grade;
+};
+
+template <>
+const db::TableScheme db::buildTableScheme<KeyedStudent>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("keyed_student",
+        {
+            {&KeyedStudent::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&KeyedStudent::code, "code", db::Cell::Flags::UNIQUE},
+            {&KeyedStudent::grade, "grade", db::Cell::Flags::DEFAULT, 50}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+struct KeyedStudentNoGrade
+{
+    int id;
+    std::string code;
+};
+
+template <>
+const db::TableScheme db::buildTableScheme<KeyedStudentNoGrade>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("keyed_student",
+        {
+            {&KeyedStudentNoGrade::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&KeyedStudentNoGrade::code, "code", db::Cell::Flags::UNIQUE}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+struct KeyedStudentNoCode
+{
+    int id;
+    int grade;
+};
+
+template <>
+const db::TableScheme db::buildTableScheme<KeyedStudentNoCode>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("keyed_student",
+        {
+            {&KeyedStudentNoCode::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&KeyedStudentNoCode::grade, "grade", db::Cell::Flags::DEFAULT, 50}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+struct KeyedStudentScore
+{
+    int id;
+    int score;
+};
+
+template <>
+const db::TableScheme db::buildTableScheme<KeyedStudentScore>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("keyed_student",
+        {
+            {&KeyedStudentScore::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&KeyedStudentScore::score, "score", db::Cell::Flags::DEFAULT, 50}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
 TEST_F(DBFacadeTestFixture, AlterBasic)
 {
     namespace sql = db::query;
@@ -184,3 +264,132 @@ TEST_F(DBFacadeTestFixture, AlterDropRename)
 
     _storage.execute(db::query::drop<NewStudent>());
 }
+
+TEST_F(DBFacadeTestFixture, AlterDropColumnKeepsKeys)
+{
+    namespace sql = db::query;
+
+    {
+        // a plain column can be dropped in place
+        TableGuard<KeyedStudent> table(_storage);
+        _storage.execute(sql::insert<KeyedStudent>({.id = 1, .code = "A", .grade = 70}));
+        _storage.execute(sql::alterScheme<KeyedStudent, KeyedStudentNoGrade>());
+
+        EXPECT_NO_THROW(_storage.verifyScheme<KeyedStudentNoGrade>());
+        EXPECT_THROW(_storage.execute(sql::insert<KeyedStudentNoGrade>({.id = 1, .code = "B"})), db::SqlException);
+        EXPECT_THROW(_storage.execute(sql::insert<KeyedStudentNoGrade>({.id = 2, .code = "A"})), db::SqlException);
+    }
+
+    {
+        // a UNIQUE column can't be dropped in place (at least in Sqlite), the table is rebuilt
+        TableGuard<KeyedStudent> table(_storage);
+        _storage.execute(sql::insert<KeyedStudent>({.id = 1, .code = "A", .grade = 70}));
+        _storage.execute(sql::alterScheme<KeyedStudent, KeyedStudentNoCode>());
+
+        EXPECT_THROW(_storage.execute(sql::insert<KeyedStudentNoCode>({.id = 1, .grade = 80})), db::SqlException);
+
+        std::vector<KeyedStudentNoCode> data = _storage.receive(sql::select<KeyedStudentNoCode>({}));
+        ASSERT_EQ(data.size(), 1);
+        EXPECT_EQ(data.at(0).grade, 70);
+    }
+}
+
+namespace
+{
+/*!
+    \brief Creates indexes the facade has no queries for and reads them back
+*/
+class IndexedDatabase final
+{
+public:
+    explicit IndexedDatabase(const char *name)
+    {
+        sqlite3_open(name, &_db);
+    }
+
+    ~IndexedDatabase()
+    {
+        sqlite3_close(_db);
+    }
+
+    void execute(const char *sql)
+    {
+        ASSERT_EQ(sqlite3_exec(_db, sql, nullptr, nullptr, nullptr), SQLITE_OK) << sqlite3_errmsg(_db);
+    }
+
+    /*!
+        \return index name -> CREATE INDEX statement
+    */
+    std::map<std::string, std::string> indexes(const char *table)
+    {
+        std::map<std::string, std::string> result;
+        sqlite3_stmt *stmt = nullptr;
+        sqlite3_prepare_v2(_db, "SELECT name, sql FROM sqlite_master WHERE type = 'index' AND sql IS NOT NULL "
+                                "AND tbl_name = ?", -1, &stmt, nullptr);
+        sqlite3_bind_text(stmt, 1, table, -1, SQLITE_TRANSIENT);
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            result[reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0))] =
+                reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+        }
+        sqlite3_finalize(stmt);
+        return result;
+    }
+
+private:
+    sqlite3 *_db = nullptr;
+};
+} // namespace
+
+TEST_F(DBFacadeTestFixture, AlterKeepsIndexes)
+{
+    namespace sql = db::query;
+
+    const char *dbName = "test_db_alter_indexes";
+    db::Facade storage(std::make_shared<db::SqliteConnection>(dbName));
+    IndexedDatabase database(dbName);
+
+    {
+        // an indexed column can't be dropped in place, the table is rebuilt without the index
+        storage.execute(sql::drop<KeyedStudent>());
+        storage.execute(sql::createTable<KeyedStudent>());
+        database.execute("CREATE INDEX keyed_student_grade ON keyed_student (grade);"
+                         "CREATE INDEX keyed_student_code ON keyed_student (code COLLATE NOCASE, id DESC);");
+        storage.execute(sql::insert<KeyedStudent>({.id = 1, .code = "A", .grade = 70}));
+
+        EXPECT_NO_THROW(storage.execute(sql::alterScheme<KeyedStudent, KeyedStudentNoGrade>()));
+
+        std::vector<KeyedStudentNoGrade> data = storage.receive(sql::select<KeyedStudentNoGrade>({}));
+        ASSERT_EQ(data.size(), 1);
+        EXPECT_EQ(data.at(0).code, "A");
+
+        auto indexes = database.indexes("keyed_student");
+        EXPECT_EQ(indexes.size(), 1);
+        EXPECT_EQ(indexes["keyed_student_code"],
+                  "CREATE INDEX keyed_student_code ON keyed_student (code COLLATE NOCASE, id DESC)");
+    }
+
+    {
+        // a rebuild recreates indexes with renamed columns and drops the ones on dropped columns
+        storage.execute(sql::drop<KeyedStudent>());
+        storage.execute(sql::createTable<KeyedStudent>());
+        database.execute("CREATE INDEX keyed_student_grade ON keyed_student (\"grade\") WHERE grade > 'grade';"
+                         "CREATE INDEX keyed_student_code ON keyed_student (code, grade);");
+        storage.execute(sql::insert<KeyedStudent>({.id = 1, .code = "A", .grade = 70}));
+
+        storage.execute(
+            sql::alterScheme<KeyedStudent, KeyedStudentScore>().renamingCell(&KeyedStudent::grade,
+                                                                             &KeyedStudentScore::score));
+
+        std::vector<KeyedStudentScore> data = storage.receive(sql::select<KeyedStudentScore>({}));
+        ASSERT_EQ(data.size(), 1);
+        EXPECT_EQ(data.at(0).score, 70);
+
+        auto indexes = database.indexes("keyed_student");
+        EXPECT_EQ(indexes.size(), 1);
+        EXPECT_EQ(indexes["keyed_student_grade"],
+                  "CREATE INDEX keyed_student_grade ON keyed_student (score) WHERE score > 'grade'");
+    }
+
+    storage.execute(sql::drop<KeyedStudent>());
+}
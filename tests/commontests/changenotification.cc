@@ -0,0 +1,169 @@
+#include "testfixture.hh"
+#include <dbfacade/insert.hh>
+#include <dbfacade/remove.hh>
+#include <dbfacade/update.hh>
+#include <dbfacade/constraints.hh>
+#include <dbfacade/sqliteconnection.hh>
+
+using namespace softeq;
+using namespace softeq::db::constraints;
+
+namespace
+{
+struct NotifiedAccount
+{
+    int id;
+    std::string owner;
+};
+
+struct NotifiedPayment
+{
+    int id;
+    int accountId;
+};
+
+using Change = db::SqliteConnection::RowChange;
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<NotifiedAccount>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("notified_account",
+        {
+            {&NotifiedAccount::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&NotifiedAccount::owner, "owner"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+template <>
+const db::TableScheme db::buildTableScheme<NotifiedPayment>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("notified_payment",
+        {
+            {&NotifiedPayment::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&NotifiedPayment::accountId, "account_id"}
+        },
+        {
+            makeConstraint<ForeignKeyConstraint>(&NotifiedPayment::accountId, &NotifiedAccount::id,
+                            addCascade(CascadeTrigger::OnDelete, CascadeAction::Cascade))
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST_F(DBFacadeTestFixture, ChangeNotification)
+{
+    namespace sql = db::query;
+
+    auto connection = std::make_shared<db::SqliteConnection>(":memory:");
+    db::Facade storage(connection);
+    storage.execute(sql::createTable<NotifiedAccount>());
+    storage.execute(sql::createTable<NotifiedPayment>());
+
+    std::vector<std::vector<Change>> accounts;
+    std::vector<std::vector<Change>> payments;
+    auto accountSubscription = connection->subscribe<NotifiedAccount>(
+        [&accounts](const std::vector<Change> &changes) { accounts.push_back(changes); });
+    connection->subscribe("notified_payment",
+                          [&payments](const std::vector<Change> &changes) { payments.push_back(changes); });
+
+    // a statement outside a transaction is delivered on its own
+    storage.execute(sql::insert<NotifiedAccount>({1, "Ann"}));
+    ASSERT_EQ(accounts.size(), 1);
+    ASSERT_EQ(accounts[0].size(), 1);
+    EXPECT_EQ(accounts[0][0].operation, Change::Operation::Insert);
+    EXPECT_EQ(accounts[0][0].table, "notified_account");
+    EXPECT_EQ(accounts[0][0].rowid, 1);
+    EXPECT_TRUE(payments.empty());
+
+    // a transaction is delivered as one batch once committed, without the changes rolled back to a savepoint
+    {
+        db::Transaction transaction(storage);
+        storage.execute(sql::insert<NotifiedAccount>({2, "Bob"}));
+        storage.execute(sql::insert<NotifiedPayment>({10, 2}));
+        storage.execTransaction([](db::Facade &storage) {
+            storage.execute(sql::insert<NotifiedAccount>({3, "Eve"}));
+            return false;
+        });
+        storage.execute(sql::update(NotifiedAccount{2, "Robert"}));
+        EXPECT_EQ(accounts.size(), 1);
+        transaction.commit();
+    }
+    ASSERT_EQ(accounts.size(), 2);
+    ASSERT_EQ(accounts[1].size(), 2);
+    EXPECT_EQ(accounts[1][0].operation, Change::Operation::Insert);
+    EXPECT_EQ(accounts[1][1].operation, Change::Operation::Update);
+    EXPECT_EQ(accounts[1][1].rowid, 2);
+    ASSERT_EQ(payments.size(), 1);
+    EXPECT_EQ(payments[0][0].rowid, 10);
+
+    // rolled back transactions are not delivered
+    storage.execTransaction([](db::Facade &storage) {
+        storage.execute(sql::remove<NotifiedAccount>());
+        return false;
+    });
+    EXPECT_EQ(accounts.size(), 2);
+
+    // rows removed by a cascade are reported for their table
+    storage.execute(sql::remove<NotifiedAccount>().where(db::field(&NotifiedAccount::id) == 2));
+    ASSERT_EQ(payments.size(), 2);
+    EXPECT_EQ(payments[1][0].operation, Change::Operation::Delete);
+    EXPECT_EQ(payments[1][0].rowid, 10);
+
+    EXPECT_EQ(accounts.size(), 3);
+
+    connection->unsubscribe(accountSubscription);
+    storage.execute(sql::insert<NotifiedAccount>({4, "Dan"}));
+    EXPECT_EQ(accounts.size(), 3);
+}
+
+TEST_F(DBFacadeTestFixture, ChangeNotificationRemoveAll)
+{
+    namespace sql = db::query;
+
+    // the table has no triggers and is not referenced, so Sqlite would truncate it on DELETE without WHERE
+    auto connection = std::make_shared<db::SqliteConnection>(":memory:");
+    db::Facade storage(connection);
+    storage.execute(sql::createTable<NotifiedAccount>());
+    storage.execute(sql::insert<NotifiedAccount>({1, "Ann"}), sql::insert<NotifiedAccount>({2, "Bob"}));
+
+    std::vector<std::vector<Change>> accounts;
+    connection->subscribe<NotifiedAccount>(
+        [&accounts](const std::vector<Change> &changes) { accounts.push_back(changes); });
+
+    storage.execute(sql::remove<NotifiedAccount>());
+    ASSERT_EQ(accounts.size(), 1);
+    ASSERT_EQ(accounts[0].size(), 2);
+    EXPECT_EQ(accounts[0][0].operation, Change::Operation::Delete);
+    EXPECT_EQ(accounts[0][0].rowid + accounts[0][1].rowid, 1 + 2);
+}
+
+TEST_F(DBFacadeTestFixture, ChangeNotificationHandlerThrows)
+{
+    namespace sql = db::query;
+
+    auto connection = std::make_shared<db::SqliteConnection>(":memory:");
+    db::Facade storage(connection);
+    storage.execute(sql::createTable<NotifiedAccount>());
+
+    std::vector<std::vector<Change>> accounts;
+    connection->subscribe<NotifiedAccount>(
+        [](const std::vector<Change> &) { throw std::runtime_error("handler failed"); });
+    connection->subscribe<NotifiedAccount>(
+        [&accounts](const std::vector<Change> &changes) { accounts.push_back(changes); });
+
+    // the commit succeeded, so the failing handler must not make the transaction look failed
+    int attempts = 0;
+    EXPECT_NO_THROW(storage.execTransaction([&attempts](db::Facade &storage) {
+        attempts++;
+        storage.execute(sql::insert<NotifiedAccount>({1, "Ann"}));
+        return true;
+    }));
+    EXPECT_EQ(attempts, 1);
+    ASSERT_EQ(accounts.size(), 1);
+    EXPECT_EQ(accounts[0][0].rowid, 1);
+}
@@ -0,0 +1,81 @@
+#include "testfixture.hh"
+#include <dbfacade/insert.hh>
+#include <dbfacade/remove.hh>
+#include <dbfacade/update.hh>
+
+using namespace softeq;
+
+namespace
+{
+struct LogRecord
+{
+    int id;
+    int ts;
+    std::string level;
+};
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<LogRecord>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("log_record",
+        {
+            {&LogRecord::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&LogRecord::ts, "ts"},
+            {&LogRecord::level, "level"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST_F(DBFacadeTestFixture, ChunkedRemoveUpdate)
+{
+    namespace sql = db::query;
+
+    TableGuard<LogRecord> logTable(_storage);
+    for (int id = 1; id <= 50; ++id)
+    {
+        // even records are old
+        _storage.execute(sql::insert<LogRecord>({id, id % 2 == 0 ? 100 : 200, "info"}));
+    }
+
+    std::vector<db::ChunkProgress> reports;
+    db::ChunkOptions options;
+    // chunks read keys before writing, so they take the write lock at once
+    EXPECT_EQ(options.transaction.behavior, db::TransactionOptions::Behavior::Immediate);
+    options.chunkSize = 10;
+    options.pause = std::chrono::milliseconds(1);
+    options.progress = [&reports](const db::ChunkProgress &progress) {
+        reports.push_back(progress);
+        return true;
+    };
+
+    db::ChunkProgress progress =
+        _storage.executeInChunks(sql::remove<LogRecord>().where(db::field(&LogRecord::ts) < 150), options);
+    EXPECT_EQ(progress.chunks, 3);
+    EXPECT_EQ(progress.rows, 25);
+    ASSERT_EQ(reports.size(), 3);
+    EXPECT_EQ(reports[1].rows, 20);
+
+    std::vector<LogRecord> data = _storage.receive(sql::select<LogRecord>({}));
+    ASSERT_EQ(data.size(), 25);
+    for (const LogRecord &record : data)
+    {
+        EXPECT_EQ(record.id % 2, 1);
+    }
+
+    // the progress callback may stop the execution
+    options.progress = [](const db::ChunkProgress &progress) { return progress.chunks < 2; };
+    LogRecord archived{0, 0, "archived"};
+    progress = _storage.executeInChunks(sql::update({&LogRecord::level}, archived), options);
+    EXPECT_EQ(progress.chunks, 2);
+    data = _storage.receive(sql::select<LogRecord>({}).where(db::field(&LogRecord::level) == "archived"));
+    EXPECT_EQ(data.size(), 20);
+
+    EXPECT_THROW(_storage.executeInChunks(sql::select<LogRecord>({})), db::SqlException);
+
+    // chunks nested in a transaction would hold the lock until it ends
+    db::Transaction transaction(_storage);
+    EXPECT_THROW(_storage.executeInChunks(sql::remove<LogRecord>()), db::SqlException);
+}
@@ -0,0 +1,178 @@
+#include "testfixture.hh"
+#include <dbfacade/insert.hh>
+#include <dbfacade/remove.hh>
+#include <dbfacade/update.hh>
+#include <dbfacade/constraints.hh>
+#include <dbfacade/sqliteconnection.hh>
+#include <dbfacade/entitycache.hh>
+
+using namespace softeq;
+using namespace softeq::db::constraints;
+
+namespace
+{
+struct CachedUser
+{
+    int id;
+    std::string name;
+};
+
+struct CachedSession
+{
+    int id;
+    int userId;
+};
+
+struct CachedTag
+{
+    std::string name;
+    int uses;
+};
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<CachedUser>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("cached_user",
+        {
+            {&CachedUser::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&CachedUser::name, "name"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+template <>
+const db::TableScheme db::buildTableScheme<CachedSession>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("cached_session",
+        {
+            {&CachedSession::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&CachedSession::userId, "user_id"}
+        },
+        {
+            makeConstraint<ForeignKeyConstraint>(&CachedSession::userId, &CachedUser::id,
+                            addCascade(CascadeTrigger::OnDelete, CascadeAction::Cascade))
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+template <>
+const db::TableScheme db::buildTableScheme<CachedTag>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("cached_tag",
+        {
+            {&CachedTag::name, "name", db::Cell::Flags::PRIMARY_KEY},
+            {&CachedTag::uses, "uses"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST_F(DBFacadeTestFixture, EntityCacheFind)
+{
+    namespace sql = db::query;
+
+    TableGuard<CachedUser> userTable(_storage);
+    TableGuard<CachedTag> tagTable(_storage);
+    _storage.execute(sql::insert<CachedUser>({1, "Ann"}));
+    _storage.execute(sql::insert<CachedUser>({2, "Bob"}));
+    _storage.execute(sql::insert<CachedTag>({"db", 3}));
+
+    // without a cache the lookup goes to the database
+    auto found = _storage.find<CachedUser>(1);
+    ASSERT_TRUE(found.second);
+    EXPECT_EQ(found.first.name, "Ann");
+    EXPECT_FALSE(_storage.find<CachedUser>(3).second);
+
+    auto cache = std::make_shared<db::EntityCache>();
+    _connection->setEntityCache(cache);
+
+    found = _storage.find<CachedUser>(1);
+    found = _storage.find<CachedUser>(1);
+    ASSERT_TRUE(found.second);
+    EXPECT_EQ(found.first.name, "Ann");
+    EXPECT_EQ(cache->counters().hits, 1);
+    EXPECT_EQ(cache->counters().misses, 1);
+    EXPECT_EQ(cache->counters().entries, 1);
+    EXPECT_GT(cache->counters().bytes, sizeof(CachedUser));
+
+    // inserts don't touch cached rows, updates do
+    _storage.execute(sql::insert<CachedUser>({3, "Cid"}));
+    EXPECT_EQ(cache->counters().entries, 1);
+    _storage.execute(sql::update(CachedUser{1, "Anna"}));
+    EXPECT_EQ(cache->counters().entries, 0);
+    found = _storage.find<CachedUser>(1);
+    EXPECT_EQ(found.first.name, "Anna");
+
+    auto tag = _storage.find<CachedTag>(std::string("db"));
+    tag = _storage.find<CachedTag>(std::string("db"));
+    ASSERT_TRUE(tag.second);
+    EXPECT_EQ(tag.first.uses, 3);
+    EXPECT_EQ(cache->counters().hits, 2);
+
+    _storage.execute(sql::remove<CachedUser>().where(db::field(&CachedUser::id) == 1));
+    EXPECT_FALSE(_storage.find<CachedUser>(1).second);
+
+    _connection->setEntityCache(nullptr);
+}
+
+TEST_F(DBFacadeTestFixture, EntityCacheLimits)
+{
+    namespace sql = db::query;
+
+    TableGuard<CachedUser> userTable(_storage);
+    for (int id = 0; id < 5; ++id)
+    {
+        _storage.execute(sql::insert<CachedUser>({id, "user"}));
+    }
+
+    db::EntityCache::Options options;
+    options.maxEntries = 3;
+    auto cache = std::make_shared<db::EntityCache>(options);
+    _connection->setEntityCache(cache);
+
+    for (int id = 0; id < 5; ++id)
+    {
+        _storage.find<CachedUser>(id);
+    }
+    EXPECT_EQ(cache->counters().entries, 3);
+    EXPECT_EQ(cache->counters().evictions, 2);
+
+    // the least recently used rows are gone
+    _storage.find<CachedUser>(4);
+    _storage.find<CachedUser>(0);
+    EXPECT_EQ(cache->counters().hits, 1);
+
+    _connection->setEntityCache(nullptr);
+}
+
+TEST_F(DBFacadeTestFixture, EntityCacheSqliteUpdateHook)
+{
+    namespace sql = db::query;
+
+    auto connection = std::make_shared<db::SqliteConnection>(":memory:");
+    db::Facade storage(connection);
+    storage.execute(sql::createTable<CachedUser>());
+    storage.execute(sql::createTable<CachedSession>());
+    storage.execute(sql::insert<CachedUser>({1, "Ann"}));
+    storage.execute(sql::insert<CachedUser>({2, "Bob"}));
+    storage.execute(sql::insert<CachedSession>({10, 1}));
+    storage.execute(sql::insert<CachedSession>({20, 2}));
+
+    auto cache = std::make_shared<db::EntityCache>();
+    connection->setEntityCache(cache);
+    EXPECT_TRUE(storage.find<CachedSession>(10).second);
+    EXPECT_TRUE(storage.find<CachedSession>(20).second);
+
+    // the cascade removes the session of the user, the other one stays cached
+    storage.execute(sql::remove<CachedUser>().where(db::field(&CachedUser::id) == 1));
+    EXPECT_EQ(cache->counters().entries, 1);
+    EXPECT_FALSE(storage.find<CachedSession>(10).second);
+    EXPECT_TRUE(storage.find<CachedSession>(20).second);
+    EXPECT_EQ(cache->counters().hits, 1);
+}
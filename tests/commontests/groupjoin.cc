@@ -0,0 +1,91 @@
+#include "testfixture.hh"
+#include <dbfacade/insert.hh>
+#include <set>
+
+using namespace softeq;
+
+namespace
+{
+struct Chapter
+{
+    std::string code;
+    int bookId;
+    std::string title;
+};
+
+struct Book
+{
+    int id;
+    std::string name;
+    std::vector<Chapter> chapters;
+};
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<Book>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("grouped_book",
+        {
+            {&Book::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&Book::name, "name"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+template <>
+const db::TableScheme db::buildTableScheme<Chapter>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("grouped_chapter",
+        {
+            {&Chapter::code, "code", db::Cell::Flags::PRIMARY_KEY},
+            {&Chapter::bookId, "book_id"},
+            {&Chapter::title, "title"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST_F(DBFacadeTestFixture, GroupJoin)
+{
+    namespace sql = db::query;
+
+    TableGuard<Book> bookTable(_storage);
+    TableGuard<Chapter> chapterTable(_storage);
+    _storage.execute(sql::insert<Book>({1, "Dune", {}}));
+    _storage.execute(sql::insert<Book>({2, "Emma", {}}));
+    _storage.execute(sql::insert<Book>({3, "Ulysses", {}}));
+    _storage.execute(sql::insert<Chapter>({"d1", 1, "Book One"}));
+    _storage.execute(sql::insert<Chapter>({"d15", 2, "Volume I"}));
+    _storage.execute(sql::insert<Chapter>({"d2", 1, "Book Two"}));
+    _storage.execute(sql::insert<Chapter>({"d3", 1, "Book Three"}));
+
+    auto chapters = sql::select<Book>({&Book::id, &Book::name, &Chapter::code, &Chapter::title})
+                        .join<Chapter>(db::field(&Chapter::bookId) == db::field(&Book::id));
+    std::vector<Book> books = _storage.receive(chapters.orderBy(&Book::id)).group(&Book::id, &Book::chapters);
+    ASSERT_EQ(books.size(), 2);
+    EXPECT_EQ(books[0].name, "Dune");
+    ASSERT_EQ(books[0].chapters.size(), 3);
+    std::set<std::string> titles;
+    for (const Chapter &chapter : books[0].chapters)
+    {
+        titles.insert(chapter.title);
+    }
+    EXPECT_EQ(titles, std::set<std::string>({"Book One", "Book Two", "Book Three"}));
+    ASSERT_EQ(books[1].chapters.size(), 1);
+    EXPECT_EQ(books[1].chapters[0].code, "d15");
+
+    // interleaved parents can't be grouped in one pass
+    auto unordered = sql::select<Book>({&Book::id, &Book::name, &Chapter::code, &Chapter::title})
+                         .join<Chapter>(db::field(&Chapter::bookId) == db::field(&Book::id))
+                         .orderBy(&Chapter::code);
+    EXPECT_THROW(std::vector<Book> interleaved = _storage.receive(unordered).group(&Book::id, &Book::chapters),
+                 db::SqlException);
+
+    // the key must be selected
+    auto keyless = sql::select<Book>({&Book::name, &Chapter::title})
+                       .join<Chapter>(db::field(&Chapter::bookId) == db::field(&Book::id));
+    EXPECT_THROW(_storage.receive(keyless).group(&Book::id, &Book::chapters), db::SqlException);
+}
@@ -6,6 +6,7 @@
 #include <dbfacade/connection.hh>
 #include <dbfacade/createtable.hh>
 #include <dbfacade/drop.hh>
+#include <dbfacade/queryplan.hh>
 
 namespace softeq
 {
@@ -22,11 +23,43 @@ protected:
     void SetUp() override;
     void TearDown() override;
 
+    /*!
+        \brief Asks the database how the query is going to be executed. The query itself is not executed.
+        \param query the query
+        \return the execution plan
+    */
+    db::QueryPlan explain(const db::SqlQuery &query);
+
 protected:
     db::Connection::SPtr _connection;
     db::Facade _storage;
 };
 
+/*!
+    \brief Checks that a table is accessed using an index, e.g. EXPECT_TRUE(usesIndex(explain(query), "employee"))
+    \param plan the execution plan
+    \param table the table name
+    \param index the index name, any index is accepted if it is empty. Note that index names are backend specific.
+    \return assertion result with the plan in the failure message
+*/
+testing::AssertionResult usesIndex(const db::QueryPlan &plan, const std::string &table, const std::string &index = "");
+
+/*!
+    \brief Checks that a table is not scanned entirely
+    \param plan the execution plan
+    \param table the table name
+    \return assertion result with the plan in the failure message
+*/
+testing::AssertionResult noFullScan(const db::QueryPlan &plan, const std::string &table);
+
+/*!
+    \brief Checks that no temporary structure (B-tree in Sqlite, filesort in MySQL) is built for a purpose
+    \param plan the execution plan
+    \param purpose what the structure is built for, e.g. "ORDER BY" or "GROUP BY"
+    \return assertion result with the plan in the failure message
+*/
+testing::AssertionResult noTempBTree(const db::QueryPlan &plan, const std::string &purpose = "ORDER BY");
+
 /*!
     \brief Function to run tests in the target module.
     Should be called from main with 'argc' and 'argv' parameters passing
@@ -194,3 +194,85 @@ TEST_F(DBFacadeTestFixture, InsertUnique)
     // insert existing value, should throw
     EXPECT_THROW(_storage.execute(query::insert(InsertUnique{1})), SqlException);
 }
+
+namespace
+{
+class StatementCounter : public db::ConnectionObserver
+{
+public:
+    void onStatement(const db::StatementStats &) override
+    {
+        ++statements;
+    }
+
+    int statements = 0;
+};
+} // namespace
+
+TEST_F(DBFacadeTestFixture, InsertBulk)
+{
+    using namespace db;
+
+    TableGuard<SomeInsert> someInsertTable(_storage);
+
+    // nothing to insert
+    _storage.execute(query::insert(std::vector<SomeInsert>()));
+
+    std::vector<SomeInsert> rows;
+    for (int id = 1; id <= 12000; ++id)
+    {
+        rows.push_back({.id = id, .name = "name" + std::to_string(id), .time = id % 7});
+    }
+
+    auto counter = std::make_shared<StatementCounter>();
+    _connection->addObserver(counter);
+    _storage.execute(query::insert(rows));
+    _connection->removeObserver(counter);
+
+    // rows are packed into multi-row statements
+    EXPECT_LT(counter->statements, 10);
+
+    std::vector<SomeInsert> data = _storage.receive(query::select<SomeInsert>({}).orderBy(&SomeInsert::id));
+    ASSERT_EQ(data.size(), rows.size());
+    EXPECT_EQ(data, rows);
+
+    // statements are split by the limits
+    CellRepresentation cellRepr;
+    SqlQueryStringBuilder builder(cellRepr);
+    StatementLimits limits;
+    limits.maxParameters = 30;
+    builder.setStatementLimits(limits);
+    auto statements = query::insert(std::vector<SomeInsert>(rows.begin(), rows.begin() + 25)).buildStatement(builder);
+    ASSERT_EQ(statements.size(), 3);
+    EXPECT_EQ(statements[0].parameters().size(), 30);
+    EXPECT_EQ(statements[2].parameters().size(), 15);
+}
+
+TEST_F(DBFacadeTestFixture, InsertBulkAtomic)
+{
+    using namespace db;
+
+    TableGuard<SomeInsert> someInsertTable(_storage);
+
+    // more parameters than Sqlite allows in a statement (250000 at most)
+    std::vector<SomeInsert> rows;
+    for (int id = 1; id <= 100000; ++id)
+    {
+        rows.push_back({.id = id, .name = "name" + std::to_string(id), .time = id % 7});
+    }
+    // the duplicate key fails the last of the statements
+    rows.push_back({.id = 1, .name = "duplicate", .time = 0});
+
+    EXPECT_THROW(_storage.execute(query::insert(rows)), SqlException);
+    EXPECT_EQ(_storage.transactionDepth(), 0);
+
+    std::vector<SomeInsert> data = _storage.receive(query::select<SomeInsert>({}));
+    EXPECT_TRUE(data.empty());
+
+    // the count of the rows is not taken over by the COMMIT
+    rows.pop_back();
+    _storage.execute(query::insert(rows));
+    EXPECT_EQ(_connection->changedRows(), rows.size());
+    data = _storage.receive(query::select<SomeInsert>({}));
+    EXPECT_EQ(data.size(), rows.size());
+}
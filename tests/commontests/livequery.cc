@@ -0,0 +1,182 @@
+#include "testfixture.hh"
+#include <dbfacade/insert.hh>
+#include <dbfacade/remove.hh>
+#include <dbfacade/update.hh>
+#include <dbfacade/livequery.hh>
+
+using namespace softeq;
+
+namespace
+{
+struct LiveTask
+{
+    int id;
+    int ownerId;
+    std::string title;
+    int done;
+};
+
+struct LiveOwner
+{
+    int id;
+    std::string name;
+};
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<LiveTask>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("live_task",
+        {
+            {&LiveTask::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&LiveTask::ownerId, "owner_id"},
+            {&LiveTask::title, "title"},
+            {&LiveTask::done, "done"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+template <>
+const db::TableScheme db::buildTableScheme<LiveOwner>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("live_owner",
+        {
+            {&LiveOwner::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&LiveOwner::name, "name"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST_F(DBFacadeTestFixture, LiveQueryDeltas)
+{
+    namespace sql = db::query;
+
+    auto connection = std::make_shared<db::SqliteConnection>(":memory:");
+    db::Facade storage(connection);
+    storage.execute(sql::createTable<LiveTask>());
+    storage.execute(sql::insert<LiveTask>({1, 1, "write", 0}));
+    storage.execute(sql::insert<LiveTask>({2, 1, "review", 1}));
+
+    std::vector<db::LiveQuery<LiveTask>::Delta> deltas;
+    db::LiveQuery<LiveTask> pending(
+        connection, sql::select<LiveTask>({}).where(db::field(&LiveTask::done) == 0),
+        [&deltas](const db::LiveQuery<LiveTask>::Delta &delta) { deltas.push_back(delta); });
+    ASSERT_EQ(pending.rows().size(), 1);
+
+    // the changes of a transaction come as one delta
+    storage.execTransaction([](db::Facade &storage) {
+        storage.execute(sql::insert<LiveTask>({3, 1, "test", 0}));
+        storage.execute(sql::update(LiveTask{1, 1, "write docs", 0}));
+        storage.execute(sql::update(LiveTask{2, 1, "review", 0}));
+        return true;
+    });
+    ASSERT_EQ(deltas.size(), 1);
+    ASSERT_EQ(deltas[0].inserted.size(), 2);
+    EXPECT_EQ(deltas[0].inserted[0].title, "review");
+    EXPECT_EQ(deltas[0].inserted[1].title, "test");
+    ASSERT_EQ(deltas[0].updated.size(), 1);
+    EXPECT_EQ(deltas[0].updated[0].title, "write docs");
+    EXPECT_TRUE(deltas[0].deleted.empty());
+
+    // rows leaving the condition are deleted ones, rows outside it make no delta
+    storage.execute(sql::update(LiveTask{3, 1, "test", 1}));
+    storage.execute(sql::insert<LiveTask>({4, 1, "release", 1}));
+    storage.execute(sql::remove<LiveTask>().where(db::field(&LiveTask::id) == 1));
+    ASSERT_EQ(deltas.size(), 3);
+    ASSERT_EQ(deltas[1].deleted.size(), 1);
+    EXPECT_EQ(deltas[1].deleted[0].title, "test");
+    ASSERT_EQ(deltas[2].deleted.size(), 1);
+    EXPECT_EQ(deltas[2].deleted[0].title, "write docs");
+
+    // an update which doesn't change the row makes no delta
+    storage.execute(sql::update(LiveTask{2, 1, "review", 0}));
+    EXPECT_EQ(deltas.size(), 3);
+
+    const std::vector<LiveTask> rows = pending.rows();
+    ASSERT_EQ(rows.size(), 1);
+    EXPECT_EQ(rows[0].id, 2);
+    EXPECT_EQ(pending.counters().fullEvaluations, 0);
+    EXPECT_EQ(pending.counters().partialEvaluations, 5);
+}
+
+TEST_F(DBFacadeTestFixture, LiveQueryJoin)
+{
+    namespace sql = db::query;
+
+    auto connection = std::make_shared<db::SqliteConnection>(":memory:");
+    db::Facade storage(connection);
+    storage.execute(sql::createTable<LiveOwner>());
+    storage.execute(sql::createTable<LiveTask>());
+    storage.execute(sql::insert<LiveOwner>({1, "Ann"}));
+    storage.execute(sql::insert<LiveOwner>({2, "Bob"}));
+    storage.execute(sql::insert<LiveTask>({1, 1, "write", 0}));
+    storage.execute(sql::insert<LiveTask>({2, 2, "review", 0}));
+
+    std::vector<db::LiveQuery<LiveTask>::Delta> deltas;
+    auto query = sql::select<LiveTask>({&LiveTask::id, &LiveTask::title})
+                     .join<LiveOwner>(db::field(&LiveOwner::id) == db::field(&LiveTask::ownerId))
+                     .where(db::field(&LiveOwner::name) == "Ann");
+    db::LiveQuery<LiveTask> annTasks(
+        connection, query, [&deltas](const db::LiveQuery<LiveTask>::Delta &delta) { deltas.push_back(delta); });
+    ASSERT_EQ(annTasks.rows().size(), 1);
+
+    // a change of the joined table re-reads the whole query
+    storage.execute(sql::update(LiveOwner{2, "Ann"}));
+    ASSERT_EQ(deltas.size(), 1);
+    ASSERT_EQ(deltas[0].inserted.size(), 1);
+    EXPECT_EQ(deltas[0].inserted[0].title, "review");
+    EXPECT_EQ(annTasks.counters().fullEvaluations, 1);
+
+    // a query must select the key to identify rows
+    EXPECT_THROW(db::LiveQuery<LiveTask>(connection, sql::select<LiveTask>({&LiveTask::title}),
+                                         [](const db::LiveQuery<LiveTask>::Delta &) {}),
+                 db::SqlException);
+}
+
+TEST_F(DBFacadeTestFixture, LiveQueryKeyOrder)
+{
+    namespace sql = db::query;
+
+    auto connection = std::make_shared<db::SqliteConnection>(":memory:");
+    db::Facade storage(connection);
+    storage.execute(sql::createTable<LiveTask>());
+    for (int id = 1; id <= 12; ++id)
+    {
+        storage.execute(sql::insert<LiveTask>({id, 1, "task" + std::to_string(id), 0}));
+    }
+
+    std::vector<db::LiveQuery<LiveTask>::Delta> deltas;
+    db::LiveQuery<LiveTask> tasks(
+        connection, sql::select<LiveTask>({}),
+        [&deltas](const db::LiveQuery<LiveTask>::Delta &delta) { deltas.push_back(delta); });
+
+    // rows are ordered by the value of an integer key, not by its text
+    std::vector<LiveTask> rows = tasks.rows();
+    ASSERT_EQ(rows.size(), 12);
+    for (int i = 0; i < 12; ++i)
+    {
+        EXPECT_EQ(rows[i].id, i + 1);
+    }
+
+    storage.execTransaction([](db::Facade &storage) {
+        storage.execute(sql::insert<LiveTask>({20, 1, "task20", 0}));
+        storage.execute(sql::update(LiveTask{10, 1, "task ten", 0}));
+        storage.execute(sql::update(LiveTask{9, 1, "task nine", 0}));
+        return true;
+    });
+    ASSERT_EQ(deltas.size(), 1);
+    ASSERT_EQ(deltas[0].inserted.size(), 1);
+    EXPECT_EQ(deltas[0].inserted[0].id, 20);
+    ASSERT_EQ(deltas[0].updated.size(), 2);
+    EXPECT_EQ(deltas[0].updated[0].id, 9);
+    EXPECT_EQ(deltas[0].updated[1].id, 10);
+
+    rows = tasks.rows();
+    ASSERT_EQ(rows.size(), 13);
+    EXPECT_EQ(rows[9].title, "task ten");
+    EXPECT_EQ(rows[12].id, 20);
+}
@@ -0,0 +1,91 @@
+#include "testfixture.hh"
+#include <dbfacade/insert.hh>
+#include <dbfacade/constraints.hh>
+
+using namespace softeq;
+using namespace softeq::db::constraints;
+
+namespace
+{
+struct Invoice;
+
+struct Customer
+{
+    int id;
+    std::string name;
+    std::vector<Invoice> invoices;
+};
+
+struct Invoice
+{
+    int id;
+    int customerId;
+    int amount;
+};
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<Customer>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("customer",
+        {
+            {&Customer::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&Customer::name, "name"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+template <>
+const db::TableScheme db::buildTableScheme<Invoice>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("invoice",
+        {
+            {&Invoice::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&Invoice::customerId, "customer_id"},
+            {&Invoice::amount, "amount"}
+        },
+        {
+            makeConstraint<ForeignKeyConstraint>(&Invoice::customerId, &Customer::id)
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST_F(DBFacadeTestFixture, LoadRelated)
+{
+    namespace sql = db::query;
+
+    TableGuard<Customer> customerTable(_storage);
+    TableGuard<Invoice> invoiceTable(_storage);
+    for (int id = 1; id <= 5; ++id)
+    {
+        _storage.execute(sql::insert<Customer>({id, "customer " + std::to_string(id), {}}));
+    }
+    _storage.execute(sql::insert<Invoice>({1, 1, 100}));
+    _storage.execute(sql::insert<Invoice>({2, 1, 200}));
+    _storage.execute(sql::insert<Invoice>({3, 3, 300}));
+    _storage.execute(sql::insert<Invoice>({4, 5, 500}));
+
+    std::vector<Customer> customers = _storage.receive(sql::select<Customer>({}));
+    ASSERT_EQ(customers.size(), 5);
+
+    // the keys are read two per query
+    std::map<int, std::vector<Invoice>> invoices = _storage.loadRelated<Invoice>(customers, &Customer::id, 2);
+    ASSERT_EQ(invoices.size(), 5);
+    EXPECT_EQ(invoices[1].size(), 2);
+    EXPECT_TRUE(invoices[2].empty());
+    ASSERT_EQ(invoices[3].size(), 1);
+    EXPECT_EQ(invoices[3][0].amount, 300);
+    EXPECT_EQ(invoices[5][0].amount, 500);
+
+    _storage.loadRelated(customers, &Customer::id, &Customer::invoices);
+    EXPECT_EQ(customers[0].invoices.size(), 2);
+    EXPECT_TRUE(customers[3].invoices.empty());
+    EXPECT_EQ(customers[4].invoices[0].id, 4);
+
+    // the relation must be declared
+    EXPECT_THROW(_storage.loadRelated<Customer>(invoices[1], &Invoice::id), db::SqlException);
+}
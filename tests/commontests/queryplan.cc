@@ -0,0 +1,61 @@
+#include "testfixture.hh"
+#include <dbfacade/select.hh>
+
+using namespace softeq;
+
+namespace
+{
+struct PlanRecord
+{
+    int id;
+    std::string code;
+    int value;
+};
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<PlanRecord>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("plan_record",
+        {
+            {&PlanRecord::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&PlanRecord::code, "code", db::Cell::Flags::UNIQUE},
+            {&PlanRecord::value, "value"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST_F(DBFacadeTestFixture, QueryPlanIndexUsage)
+{
+    namespace sql = db::query;
+
+    TableGuard<PlanRecord> recordTable(_storage);
+
+    auto byId = explain(sql::select<PlanRecord>({}).where(db::field(&PlanRecord::id) == 1));
+    EXPECT_TRUE(usesIndex(byId, "plan_record"));
+    EXPECT_TRUE(noFullScan(byId, "plan_record"));
+
+    auto byCode = explain(sql::select<PlanRecord>({}).where(db::field(&PlanRecord::code) == "A-1"));
+    EXPECT_TRUE(usesIndex(byCode, "plan_record"));
+    EXPECT_TRUE(noFullScan(byCode, "plan_record"));
+
+    // there is no index on 'value'
+    auto byValue = explain(sql::select<PlanRecord>({}).where(db::field(&PlanRecord::value) == 1));
+    EXPECT_FALSE(usesIndex(byValue, "plan_record"));
+    EXPECT_FALSE(noFullScan(byValue, "plan_record"));
+
+    // the table is not accessed by the query
+    EXPECT_FALSE(usesIndex(byValue, "other_table"));
+}
+
+TEST_F(DBFacadeTestFixture, QueryPlanOrderBy)
+{
+    namespace sql = db::query;
+
+    TableGuard<PlanRecord> recordTable(_storage);
+
+    EXPECT_TRUE(noTempBTree(explain(sql::select<PlanRecord>({}).orderBy(&PlanRecord::id))));
+    EXPECT_FALSE(noTempBTree(explain(sql::select<PlanRecord>({}).orderBy(&PlanRecord::value)), "ORDER BY"));
+}
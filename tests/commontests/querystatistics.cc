@@ -0,0 +1,89 @@
+#include "testfixture.hh"
+#include <dbfacade/insert.hh>
+#include <dbfacade/select.hh>
+#include <dbfacade/querystatistics.hh>
+
+using namespace softeq;
+
+namespace
+{
+struct StatRecord
+{
+    int id;
+    std::string name;
+};
+
+/*!
+    \brief Finds an entry which fingerprint starts with the prefix
+*/
+std::pair<db::QueryStatistics::Entry, bool> findEntry(const db::QueryStatistics &statistics, const std::string &prefix)
+{
+    for (const auto &entry : statistics.snapshot())
+    {
+        if (entry.first.compare(0, prefix.size(), prefix) == 0)
+        {
+            return {entry.second, true};
+        }
+    }
+    return {db::QueryStatistics::Entry{}, false};
+}
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<StatRecord>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("stat_record",
+        {
+            {&StatRecord::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&StatRecord::name, "name"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST(Fingerprint, Literals)
+{
+    EXPECT_EQ(db::fingerprint("SELECT a FROM t1 WHERE b = 'it''s'  AND c > 10.5 LIMIT 0, 20;"),
+              "SELECT a FROM t1 WHERE b = ? AND c > ? LIMIT ?, ?;");
+    EXPECT_EQ(db::fingerprint("INSERT INTO tmp_2 (id) VALUES (?);"), "INSERT INTO tmp_2 (id) VALUES (?);");
+}
+
+TEST_F(DBFacadeTestFixture, QueryStatisticsAggregation)
+{
+    namespace sql = db::query;
+
+    TableGuard<StatRecord> recordTable(_storage);
+
+    auto statistics = std::make_shared<db::QueryStatistics>();
+    _connection->addObserver(statistics);
+
+    _storage.execute(sql::insert<StatRecord>({1, "John"}));
+    _storage.execute(sql::insert<StatRecord>({2, "Jane"}));
+    _storage.execute(sql::insert<StatRecord>({3, "Jack"}));
+    EXPECT_THROW(_storage.execute(sql::insert<StatRecord>({3, "Jean"})), db::SqlException);
+
+    std::vector<StatRecord> data = _storage.receive(sql::select<StatRecord>({}));
+    EXPECT_EQ(data.size(), 3);
+
+    auto insert = findEntry(*statistics, "INSERT INTO stat_record");
+    ASSERT_TRUE(insert.second);
+    EXPECT_EQ(insert.first.calls, 4);
+    EXPECT_EQ(insert.first.errors, 1);
+    EXPECT_LE(insert.first.min, insert.first.max);
+
+    auto select = findEntry(*statistics, "SELECT * FROM stat_record");
+    ASSERT_TRUE(select.second);
+    EXPECT_EQ(select.first.calls, 1);
+    EXPECT_EQ(select.first.rows, 3);
+    EXPECT_GE(select.first.percentile(0.99), select.first.percentile(0.5));
+
+    std::string json = statistics->toJson();
+    EXPECT_NE(json.find("\"fingerprint\":\"INSERT INTO stat_record"), std::string::npos);
+
+    // nothing is collected after the observer is detached
+    _connection->removeObserver(statistics);
+    statistics->reset();
+    _storage.execute(sql::insert<StatRecord>({4, "Jean"}));
+    EXPECT_TRUE(statistics->snapshot().empty());
+}
@@ -0,0 +1,164 @@
+#include "testfixture.hh"
+#include <dbfacade/insert.hh>
+#include <dbfacade/select.hh>
+#include <dbfacade/update.hh>
+#include <dbfacade/resultcache.hh>
+
+using namespace softeq;
+
+namespace
+{
+struct CachedAuthor
+{
+    int id;
+    std::string name;
+};
+
+struct CachedBook
+{
+    int id;
+    int authorId;
+    std::string title;
+};
+
+/*!
+    \brief Detaches the cache when the test ends
+*/
+class CacheGuard final
+{
+public:
+    CacheGuard(const db::Connection::SPtr &connection, const db::ResultCache::SPtr &cache)
+        : _connection(connection)
+    {
+        _connection->setResultCache(cache);
+    }
+
+    ~CacheGuard()
+    {
+        _connection->setResultCache(nullptr);
+    }
+
+private:
+    db::Connection::SPtr _connection;
+};
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<CachedAuthor>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("cached_author",
+        {
+            {&CachedAuthor::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&CachedAuthor::name, "name"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+template <>
+const db::TableScheme db::buildTableScheme<CachedBook>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("cached_book",
+        {
+            {&CachedBook::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&CachedBook::authorId, "author_id"},
+            {&CachedBook::title, "title"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST_F(DBFacadeTestFixture, ResultCacheInvalidation)
+{
+    namespace sql = db::query;
+
+    TableGuard<CachedAuthor> authorTable(_storage);
+    TableGuard<CachedBook> bookTable(_storage);
+    _storage.execute(sql::insert<CachedAuthor>({1, "Tolkien"}));
+    _storage.execute(sql::insert<CachedBook>({1, 1, "The Hobbit"}));
+
+    auto cache = std::make_shared<db::ResultCache>();
+    CacheGuard guard(_connection, cache);
+
+    auto authors = sql::select<CachedAuthor>({}).where(db::field(&CachedAuthor::id) == 1);
+    std::vector<CachedAuthor> data = _storage.receive(authors);
+    data = _storage.receive(authors);
+    ASSERT_EQ(data.size(), 1);
+    EXPECT_EQ(data[0].name, "Tolkien");
+    EXPECT_EQ(cache->counters().hits, 1);
+    EXPECT_EQ(cache->counters().misses, 1);
+
+    // other values are another key
+    data = _storage.receive(sql::select<CachedAuthor>({}).where(db::field(&CachedAuthor::id) == 2));
+    EXPECT_TRUE(data.empty());
+    EXPECT_EQ(cache->counters().misses, 2);
+
+    // a change of another table keeps the result
+    _storage.execute(sql::insert<CachedBook>({2, 1, "The Silmarillion"}));
+    data = _storage.receive(authors);
+    EXPECT_EQ(cache->counters().hits, 2);
+
+    _storage.execute(sql::update(CachedAuthor{1, "J. R. R. Tolkien"}));
+    data = _storage.receive(authors);
+    ASSERT_EQ(data.size(), 1);
+    EXPECT_EQ(data[0].name, "J. R. R. Tolkien");
+    EXPECT_EQ(cache->counters().misses, 3);
+
+    // a joined table invalidates the result too
+    auto books = sql::select<CachedBook>({&CachedBook::title})
+                     .join<CachedAuthor>(db::field(&CachedAuthor::id) == db::field(&CachedBook::authorId));
+    std::vector<CachedBook> titles = _storage.receive(books);
+    EXPECT_EQ(titles.size(), 2);
+    _storage.execute(sql::insert<CachedAuthor>({2, "Lewis"}));
+    titles = _storage.receive(books);
+    EXPECT_EQ(cache->counters().hits, 2);
+    EXPECT_GE(cache->counters().invalidations, 2);
+
+    // reads inside a transaction may see its changes, so they bypass the cache
+    _storage.execTransaction([&](db::Facade &storage) {
+        storage.execute(sql::update(CachedAuthor{1, "Ronald Tolkien"}));
+        std::vector<CachedAuthor> inside = storage.receive(authors);
+        EXPECT_EQ(inside[0].name, "Ronald Tolkien");
+        return false;
+    });
+    const auto before = cache->counters();
+    data = _storage.receive(authors);
+    ASSERT_EQ(data.size(), 1);
+    EXPECT_EQ(data[0].name, "J. R. R. Tolkien");
+    EXPECT_EQ(cache->counters().misses, before.misses + 1);
+    EXPECT_GT(cache->counters().hitRate(), 0.0);
+}
+
+TEST_F(DBFacadeTestFixture, ResultCacheBounds)
+{
+    namespace sql = db::query;
+
+    TableGuard<CachedAuthor> authorTable(_storage);
+    _storage.execute(sql::insert<CachedAuthor>({1, "Tolkien"}));
+
+    db::ResultCache::Options options;
+    options.maxEntries = 1;
+    auto cache = std::make_shared<db::ResultCache>(options);
+    CacheGuard guard(_connection, cache);
+
+    auto first = sql::select<CachedAuthor>({}).where(db::field(&CachedAuthor::id) == 1);
+    auto second = sql::select<CachedAuthor>({}).where(db::field(&CachedAuthor::id) == 2);
+    std::vector<CachedAuthor> data = _storage.receive(first);
+    data = _storage.receive(second);
+    data = _storage.receive(first);
+    EXPECT_EQ(cache->counters().hits, 0);
+    EXPECT_EQ(cache->counters().evictions, 2);
+
+    // expired results are not used
+    options.maxEntries = 10;
+    options.ttl = std::chrono::milliseconds(0);
+    cache = std::make_shared<db::ResultCache>(options);
+    _connection->setResultCache(cache);
+    data = _storage.receive(first);
+    data = _storage.receive(first);
+    EXPECT_EQ(cache->counters().hits, 0);
+    ASSERT_EQ(data.size(), 1);
+    EXPECT_EQ(data[0].name, "Tolkien");
+}
@@ -1,6 +1,8 @@
 #include "testfixture.hh"
 #include "dbfacade/select.hh"
 #include "dbfacade/insert.hh"
+#include "dbfacade/sqliteconnection.hh"
+#include <set>
 
 using namespace softeq;
 
@@ -222,6 +224,43 @@ TEST_F(DBFacadeTestFixture, SelectInTest)
     EXPECT_EQ(data.front().id, 3);
 }
 
+TEST_F(DBFacadeTestFixture, SelectInValuesTest)
+{
+    using namespace db;
+
+    TableGuard<SomeSelect> someSelectTable(_storage);
+
+    _storage.execute(query::insert<SomeSelect>({.id = 1, .name = "name1", .time = "2021-01-01"}));
+    _storage.execute(query::insert<SomeSelect>({.id = 2, .name = "name \"2\"", .time = "2021-01-02"}));
+    _storage.execute(query::insert<SomeSelect>({.id = 3, .name = "name3", .time = "2021-01-03"}));
+
+    // more values than a statement can bind one by one
+    std::vector<int> ids;
+    for (int id = 3; id < 5000; ++id)
+    {
+        ids.push_back(id);
+    }
+    std::vector<SomeSelect> data =
+        _storage.receive(query::select<SomeSelect>({}).where(db::field(&SomeSelect::id).inValues(ids)));
+    ASSERT_EQ(data.size(), 1);
+    EXPECT_EQ(data.front().id, 3);
+
+    data = _storage.receive(query::select<SomeSelect>({}).where(
+        db::field(&SomeSelect::name).inValues(std::set<std::string>{"name1", "name \"2\"", "name"})));
+    EXPECT_EQ(data.size(), 2);
+
+    data = _storage.receive(
+        query::select<SomeSelect>({}).where(db::field(&SomeSelect::id).inValues(std::vector<int>())));
+    EXPECT_TRUE(data.empty());
+
+    // the statement text doesn't depend on the number of values
+    CellRepresentation cellRepr;
+    SqliteQueryStringBuilder builder(cellRepr, 3040000);
+    auto few = query::select<SomeSelect>({}).where(db::field(&SomeSelect::id).inValues(std::vector<int>{1}));
+    auto many = query::select<SomeSelect>({}).where(db::field(&SomeSelect::id).inValues(ids));
+    EXPECT_EQ(few.buildStatement(builder).front().compose(), many.buildStatement(builder).front().compose());
+}
+
 TEST_F(DBFacadeTestFixture, SelectLimits)
 {
     using namespace db;
@@ -248,3 +287,29 @@ TEST_F(DBFacadeTestFixture, SelectLimits)
     EXPECT_EQ(data.size(), 2);
     EXPECT_TRUE(data.at(0).id == 2 && data.at(1).id == 3);
 }
+
+TEST_F(DBFacadeTestFixture, SelectStreaming)
+{
+    using namespace db;
+
+    TableGuard<SomeSelect> someSelectTable(_storage);
+
+    for (int id = 1; id <= 10; ++id)
+    {
+        std::string suffix = std::to_string(id);
+        _storage.execute(query::insert<SomeSelect>({.id = id, .name = "name" + suffix, .time = "2021-01-" + suffix}));
+    }
+
+    auto buffered = query::select<SomeSelect>({}).orderBy(&SomeSelect::id);
+    EXPECT_EQ(buffered.fetchOptions().mode, FetchOptions::Mode::Buffered);
+
+    // rows are fetched from the cursor in chunks smaller than the result
+    auto streaming = query::select<SomeSelect>({}).orderBy(&SomeSelect::id).fetch(FetchOptions::streaming(3));
+    EXPECT_EQ(streaming.fetchOptions().mode, FetchOptions::Mode::Streaming);
+    EXPECT_EQ(streaming.fetchOptions().prefetchRows, 3);
+
+    std::vector<SomeSelect> expected = _storage.receive(buffered);
+    std::vector<SomeSelect> data = _storage.receive(streaming);
+    ASSERT_EQ(data.size(), 10);
+    EXPECT_EQ(data, expected);
+}
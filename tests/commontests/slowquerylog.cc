@@ -0,0 +1,85 @@
+#include "testfixture.hh"
+#include <dbfacade/insert.hh>
+#include <dbfacade/select.hh>
+#include <dbfacade/slowquerylog.hh>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace softeq;
+
+namespace
+{
+struct SlowRecord
+{
+    int id;
+    std::string name;
+};
+} // namespace
+
+template <>
+const db::TableScheme db::buildTableScheme<SlowRecord>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("slow_record",
+        {
+            {&SlowRecord::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&SlowRecord::name, "name"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST_F(DBFacadeTestFixture, SlowQueryLogCapture)
+{
+    namespace sql = db::query;
+
+    TableGuard<SlowRecord> recordTable(_storage);
+
+    const std::string logPath = testing::TempDir() + "dbfacade_slow_query.log";
+    std::remove(logPath.c_str());
+
+    db::SlowQueryLog::Options options;
+    options.threshold = db::StatementStats::Duration::zero(); // everything is slow
+    options.capacity = 2;
+    options.filePath = logPath;
+    auto log = std::make_shared<db::SlowQueryLog>(_connection, options);
+    _connection->addObserver(log);
+
+    _storage.execute(sql::insert<SlowRecord>({1, "John"}));
+    _storage.execute(sql::insert<SlowRecord>({2, "Jane"}));
+    std::vector<SlowRecord> data =
+        _storage.receive(sql::select<SlowRecord>({}).where(db::field(&SlowRecord::name) == "Jane"));
+    ASSERT_EQ(data.size(), 1);
+
+    _connection->removeObserver(log);
+
+    // the oldest entry is dropped
+    auto entries = log->entries();
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(entries[0].sql.compare(0, 23, "INSERT INTO slow_record"), 0);
+
+    const auto &select = entries[1];
+    EXPECT_EQ(select.sql.compare(0, 25, "SELECT * FROM slow_record"), 0);
+    ASSERT_EQ(select.parameters.size(), 1);
+    EXPECT_EQ(select.parameters[0], "Jane");
+    EXPECT_TRUE(select.error.empty());
+
+    // there is no index on 'name', so the table is scanned
+    ASSERT_FALSE(select.plan.steps.empty());
+    EXPECT_EQ(select.plan.steps[0].table, "slow_record");
+    EXPECT_TRUE(select.plan.steps[0].fullScan);
+
+    // all entries are in the file, including the dropped one
+    std::ifstream file(logPath);
+    std::stringstream content;
+    content << file.rdbuf();
+    EXPECT_NE(content.str().find("VALUES"), std::string::npos);
+    EXPECT_EQ(content.str().find("# Plan: "), content.str().rfind("# Plan: ")) << content.str();
+    EXPECT_NE(content.str().find("# Parameters: 'Jane'"), std::string::npos);
+
+    log->clear();
+    EXPECT_TRUE(log->entries().empty());
+    std::remove(logPath.c_str());
+}
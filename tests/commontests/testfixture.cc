@@ -1,8 +1,65 @@
 #include "testfixture.hh"
 
+using namespace softeq;
+
+db::QueryPlan DBFacadeTestFixture::explain(const db::SqlQuery &query)
+{
+    return _connection->explain(query);
+}
+
+testing::AssertionResult softeq::usesIndex(const db::QueryPlan &plan, const std::string &table,
+                                           const std::string &index)
+{
+    bool accessed = false;
+    for (const auto &step : plan.steps)
+    {
+        if (step.table != table)
+        {
+            continue;
+        }
+        accessed = true;
+        if (step.index.empty() || (!index.empty() && step.index != index))
+        {
+            return testing::AssertionFailure() << "table '" << table << "' is accessed without index '" << index
+                                               << "':\n"
+                                               << plan.toString();
+        }
+    }
+    if (!accessed)
+    {
+        return testing::AssertionFailure() << "table '" << table << "' is not accessed:\n" << plan.toString();
+    }
+    return testing::AssertionSuccess();
+}
+
+testing::AssertionResult softeq::noFullScan(const db::QueryPlan &plan, const std::string &table)
+{
+    for (const auto &step : plan.steps)
+    {
+        // scanning a covering index is still a full scan
+        if (step.table == table && step.fullScan)
+        {
+            return testing::AssertionFailure() << "table '" << table << "' is scanned:\n" << plan.toString();
+        }
+    }
+    return testing::AssertionSuccess();
+}
+
+testing::AssertionResult softeq::noTempBTree(const db::QueryPlan &plan, const std::string &purpose)
+{
+    for (const auto &step : plan.steps)
+    {
+        if (step.temporary == purpose)
+        {
+            return testing::AssertionFailure() << "a temporary structure is built for " << purpose << ":\n"
+                                               << plan.toString();
+        }
+    }
+    return testing::AssertionSuccess();
+}
+
 int softeq::RunTests(int argc, char *argv[])
 {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
-
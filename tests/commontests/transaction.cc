@@ -1,6 +1,11 @@
 #include "testfixture.hh"
 #include <dbfacade/insert.hh>
 #include <dbfacade/select.hh>
+#include <dbfacade/sqliteconnection.hh>
+#include <dbfacade/sqliteexception.hh>
+#include <dbfacade/transactionretrier.hh>
+#include <sqlite3.h>
+#include <thread>
 
 using namespace softeq;
 
@@ -71,3 +76,186 @@ TEST_F(DBFacadeTestFixture, TransactionSimple)
     EXPECT_EQ(data.size(), 4);
 }
 
+
+TEST_F(DBFacadeTestFixture, TransactionNested)
+{
+    namespace sql = db::query;
+
+    TableGuard<Student> studentTable(_storage);
+
+    _storage.execTransaction(db::TransactionOptions::immediate(), [](db::Facade &storage) {
+        storage.execute(sql::insert<Student>({0, "John"}));
+
+        // the nested rollback undoes its own changes only
+        storage.execTransaction([](db::Facade &storage) {
+            storage.execute(sql::insert<Student>({1, "Jane"}));
+            return false;
+        });
+
+        storage.execTransaction([](db::Facade &storage) {
+            storage.execute(sql::insert<Student>({2, "Jack"}));
+            storage.execTransaction([](db::Facade &storage) {
+                storage.execute(sql::insert<Student>({3, "Jean"}));
+                return true;
+            });
+            return true;
+        });
+        return true;
+    });
+
+    std::vector<Student> data = _storage.receive(sql::select<Student>({}));
+    ASSERT_EQ(data.size(), 3);
+    EXPECT_EQ(data[0].name, "John");
+    EXPECT_EQ(data[1].name, "Jack");
+    EXPECT_EQ(data[2].name, "Jean");
+
+    // the outer rollback undoes the committed nested transactions too
+    _storage.execTransaction([](db::Facade &storage) {
+        storage.execTransaction(sql::insert<Student>({4, "Joan"}));
+        return false;
+    });
+    data = _storage.receive(sql::select<Student>({}));
+    EXPECT_EQ(data.size(), 3);
+}
+
+TEST_F(DBFacadeTestFixture, TransactionException)
+{
+    namespace sql = db::query;
+
+    TableGuard<Student> studentTable(_storage);
+
+    EXPECT_THROW(_storage.execTransaction([](db::Facade &storage) {
+        storage.execute(sql::insert<Student>({0, "John"}));
+        storage.execute(sql::insert<Student>({0, "John"})); // duplicate primary key
+        return true;
+    }),
+                 db::SqlException);
+
+    // the transaction is rolled back, so a new one can be started
+    _storage.execTransaction(sql::insert<Student>({1, "Jane"}));
+
+    std::vector<Student> data = _storage.receive(sql::select<Student>({}));
+    ASSERT_EQ(data.size(), 1);
+    EXPECT_EQ(data[0].name, "Jane");
+}
+
+TEST_F(DBFacadeTestFixture, TransactionRetry)
+{
+    namespace sql = db::query;
+
+    const char *dbName = "test_db_transaction_retry";
+    db::Facade first(std::make_shared<db::SqliteConnection>(dbName));
+    db::Facade second(std::make_shared<db::SqliteConnection>(dbName));
+    first.execute(sql::drop<Student>());
+    first.execute(sql::createTable<Student>());
+
+    db::TransactionRetrier::Policy policy;
+    policy.attempts = 3;
+    policy.initialBackoff = std::chrono::milliseconds(1);
+    db::TransactionRetrier retrier(policy);
+
+    int attempts = 0;
+    retrier.run(first, [&](db::Facade &storage) {
+        ++attempts;
+        if (attempts == 1)
+        {
+            // the read lock can't be upgraded while another connection holds the write one
+            std::vector<Student> data = storage.receive(sql::select<Student>({}));
+            second.execute(sql::beginTransaction(db::TransactionOptions::immediate()));
+            second.execute(sql::insert<Student>({0, "John"}));
+        }
+        else
+        {
+            second.execute(sql::commitTransaction());
+        }
+        storage.execute(sql::insert<Student>({1, "Jane"}));
+        return true;
+    });
+
+    EXPECT_EQ(attempts, 2);
+    auto metrics = retrier.metrics();
+    EXPECT_EQ(metrics.transactions, 1);
+    EXPECT_EQ(metrics.retries, 1);
+    EXPECT_EQ(metrics.exhausted, 0);
+
+    std::vector<Student> data = first.receive(sql::select<Student>({}));
+    EXPECT_EQ(data.size(), 2);
+
+    // errors that are not transient are not retried
+    attempts = 0;
+    EXPECT_THROW(retrier.run(first,
+                             [&](db::Facade &storage) {
+                                 ++attempts;
+                                 storage.execute(sql::insert<Student>({1, "Jane"}));
+                                 return true;
+                             }),
+                 db::SqlException);
+    EXPECT_EQ(attempts, 1);
+    EXPECT_FALSE(db::SqliteException(SQLITE_CONSTRAINT).retryable());
+    EXPECT_TRUE(db::SqliteException(SQLITE_BUSY).retryable());
+
+    // nested transactions are not retried, transient errors go to the outer one
+    attempts = 0;
+    first.execTransaction([&](db::Facade &storage) {
+        EXPECT_THROW(retrier.run(storage,
+                                 [&](db::Facade &) -> bool {
+                                     ++attempts;
+                                     throw db::SqliteException(SQLITE_BUSY);
+                                 }),
+                     db::SqlException);
+        return false;
+    });
+    EXPECT_EQ(attempts, 1);
+    metrics = retrier.metrics();
+    EXPECT_EQ(metrics.transactions, 2);
+    EXPECT_EQ(metrics.retries, 1);
+    EXPECT_EQ(metrics.exhausted, 0);
+
+    first.execute(sql::drop<Student>());
+}
+
+TEST_F(DBFacadeTestFixture, TransactionGuard)
+{
+    namespace sql = db::query;
+
+    TableGuard<Student> studentTable(_storage);
+
+    {
+        db::Transaction transaction = _storage.transaction(db::TransactionOptions::immediate());
+        _storage.execute(sql::insert<Student>({0, "John"}));
+        EXPECT_EQ(_storage.transactionDepth(), 1);
+
+        // a moved guard keeps the transaction
+        db::Transaction moved(std::move(transaction));
+        EXPECT_FALSE(transaction.active());
+        EXPECT_TRUE(moved.active());
+
+        {
+            db::Transaction nested(_storage);
+            _storage.execute(sql::insert<Student>({1, "Jane"}));
+            // rolled back by the destructor
+        }
+        moved.commit();
+        EXPECT_FALSE(moved.active());
+        EXPECT_THROW(moved.commit(), db::SqlException);
+    }
+    EXPECT_EQ(_storage.transactionDepth(), 0);
+
+    std::vector<Student> data = _storage.receive(sql::select<Student>({}));
+    ASSERT_EQ(data.size(), 1);
+    EXPECT_EQ(data[0].name, "John");
+
+    // another thread waits for the end of the transaction instead of writing into it
+    std::thread writer;
+    {
+        db::Transaction transaction(_storage);
+        _storage.execute(sql::insert<Student>({2, "Jack"}));
+        writer = std::thread([this]() { _storage.execute(sql::insert<Student>({3, "Jean"})); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    writer.join();
+
+    data = _storage.receive(sql::select<Student>({}));
+    ASSERT_EQ(data.size(), 2);
+    EXPECT_EQ(data[1].name, "Jean");
+}
@@ -8,6 +8,7 @@
 #include <dbfacade/typehint.hh>
 
 #include <chrono>
+#include <limits>
 #include <memory>
 
 using namespace softeq;
@@ -157,6 +158,51 @@ const db::TableScheme db::buildTableScheme<Student>()
     return scheme;
 }
 
+struct IntegerLimits
+{
+    int id;
+    std::int8_t small;
+    std::int64_t minimal;
+    std::int64_t maximal;
+    std::uint32_t unsignedMaximal;
+};
+
+template <>
+const db::TableScheme db::buildTableScheme<IntegerLimits>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("integer_limits",
+        {
+            {&IntegerLimits::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&IntegerLimits::small, "small"},
+            {&IntegerLimits::minimal, "minimal"},
+            {&IntegerLimits::maximal, "maximal"},
+            {&IntegerLimits::unsignedMaximal, "unsigned_maximal"},
+        }
+    ); // clang-format on
+    return scheme;
+}
+
+TEST_F(DBFacadeTestFixture, SerializersIntegerLimits)
+{
+    namespace sql = db::query;
+
+    TableGuard<IntegerLimits> table(_storage);
+
+    _storage.execute(sql::insert<IntegerLimits>({.id = 1,
+                                                 .small = -100,
+                                                 .minimal = std::numeric_limits<std::int64_t>::min(),
+                                                 .maximal = std::numeric_limits<std::int64_t>::max(),
+                                                 .unsignedMaximal = std::numeric_limits<std::uint32_t>::max()}));
+
+    std::vector<IntegerLimits> data = _storage.receive(sql::select<IntegerLimits>({}));
+    ASSERT_EQ(data.size(), 1);
+    EXPECT_EQ(data[0].small, -100); // 8-bit integers are numbers, not characters
+    EXPECT_EQ(data[0].minimal, std::numeric_limits<std::int64_t>::min());
+    EXPECT_EQ(data[0].maximal, std::numeric_limits<std::int64_t>::max());
+    EXPECT_EQ(data[0].unsignedMaximal, std::numeric_limits<std::uint32_t>::max());
+}
+
 TEST_F(DBFacadeTestFixture, SerializersBasic)
 {
     namespace sql = db::query;
@@ -2,6 +2,7 @@
 #include <dbfacade/update.hh>
 #include <dbfacade/insert.hh>
 #include <dbfacade/select.hh>
+#include <dbfacade/remove.hh>
 
 using namespace softeq;
 
@@ -33,6 +34,27 @@ const db::TableScheme db::buildTableScheme<SomeUpdate>()
     return scheme;
 }
 
+struct TrackedAccount
+{
+    int id;
+    std::string owner;
+    int balance;
+};
+
+template <>
+const db::TableScheme db::buildTableScheme<TrackedAccount>()
+{
+    // clang-format off
+    static const auto scheme =  db::TableScheme("TrackedAccount",
+        {
+            {&TrackedAccount::id, "id", db::Cell::PRIMARY_KEY | db::Cell::AUTOINCREMENT},
+            {&TrackedAccount::owner, "owner"},
+            {&TrackedAccount::balance, "balance"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
 TEST_F(DBFacadeTestFixture, UpdateWhere)
 {
     using namespace db;
@@ -103,3 +125,130 @@ TEST_F(DBFacadeTestFixture, UpdateNonPrimary)
     EXPECT_EQ(data.size(), 1);
     EXPECT_EQ(data.at(0).time, "2021-01-03");
 }
+
+TEST_F(DBFacadeTestFixture, UpdateTracked)
+{
+    using namespace db;
+
+    TableGuard<SomeUpdate> someUpdateTable(_storage);
+
+    _storage.execute(query::insert<SomeUpdate>({.id = 1, .name = "name1", .time = "2021-01-01", .intval = 1}));
+    _storage.execute(query::insert<SomeUpdate>({.id = 2, .name = "name2", .time = "2021-01-02", .intval = 2}));
+
+    std::vector<SomeUpdate> loaded = _storage.receive(query::select<SomeUpdate>({}).orderBy(&SomeUpdate::id));
+    std::vector<Tracked<SomeUpdate>> rows = track(std::move(loaded));
+    ASSERT_EQ(rows.size(), 2);
+
+    Tracked<SomeUpdate> &row = rows[0];
+    EXPECT_FALSE(row.dirty());
+    EXPECT_THROW(query::update(row), SqlException);
+
+    // only the changed column is written
+    row->name = "NewName1";
+    EXPECT_TRUE(row.dirty());
+    UpdateQuery update = query::update(row);
+    ASSERT_EQ(update.cells().size(), 1);
+    EXPECT_EQ(update.cells()[0].unqualifiedName(), "name");
+
+    // a concurrent change of another column is kept
+    _storage.execute(query::update({&SomeUpdate::intval}, SomeUpdate{.id = 1, .name = "", .time = "", .intval = 7})
+                         .where(field(&SomeUpdate::id) == 1));
+    _storage.execute(update);
+    row.commit();
+    EXPECT_FALSE(row.dirty());
+
+    std::vector<SomeUpdate> data = _storage.receive(query::select<SomeUpdate>({}).orderBy(&SomeUpdate::id));
+    EXPECT_TRUE(data.at(0) == (SomeUpdate{.id = 1, .name = "NewName1", .time = "2021-01-01", .intval = 7}));
+    EXPECT_EQ(data.at(1).name, "name2");
+
+    // an optimistic update does nothing if a changed column was changed concurrently
+    Tracked<SomeUpdate> &other = rows[1];
+    other->intval = 20;
+    _storage.execute(query::update({&SomeUpdate::intval}, SomeUpdate{.id = 2, .name = "", .time = "", .intval = 3})
+                         .where(field(&SomeUpdate::id) == 2));
+    _storage.execute(query::update(other, true));
+    data = _storage.receive(query::select<SomeUpdate>({}).where(field(&SomeUpdate::id) == 2));
+    EXPECT_EQ(data.at(0).intval, 3);
+
+    // ...and updates the row if it was not
+    Tracked<SomeUpdate> fresh(data.at(0));
+    fresh->intval = 20;
+    _storage.execute(query::update(fresh, true));
+    data = _storage.receive(query::select<SomeUpdate>({}).where(field(&SomeUpdate::id) == 2));
+    EXPECT_EQ(data.at(0).intval, 20);
+}
+
+TEST_F(DBFacadeTestFixture, UpdateTrackedAutoincrementKey)
+{
+    using namespace db;
+
+    TableGuard<TrackedAccount> accountTable(_storage);
+
+    _storage.execute(query::insert<TrackedAccount>({.id = 1, .owner = "Bob", .balance = 10}));
+    _storage.execute(query::insert<TrackedAccount>({.id = 2, .owner = "Bob", .balance = 20}));
+
+    std::vector<TrackedAccount> loaded =
+        _storage.receive(query::select<TrackedAccount>({}).orderBy(&TrackedAccount::id));
+    std::vector<Tracked<TrackedAccount>> accounts = track(std::move(loaded));
+    ASSERT_EQ(accounts.size(), 2);
+
+    // an AUTOINCREMENT key is still the key: only the row itself is updated, whatever the old values are
+    accounts[0]->owner = "Alice";
+    UpdateQuery update = query::update(accounts[0], true);
+    ASSERT_EQ(update.cells().size(), 1);
+    _storage.execute(update);
+    EXPECT_NO_THROW(_storage.execute(query::update(accounts[0])));
+
+    std::vector<TrackedAccount> data =
+        _storage.receive(query::select<TrackedAccount>({}).orderBy(&TrackedAccount::id));
+    ASSERT_EQ(data.size(), 2);
+    EXPECT_EQ(data.at(0).owner, "Alice");
+    EXPECT_EQ(data.at(1).owner, "Bob");
+}
+
+TEST_F(DBFacadeTestFixture, UpdateTrackedConflict)
+{
+    using namespace db;
+
+    TableGuard<TrackedAccount> accountTable(_storage);
+
+    _storage.execute(query::insert<TrackedAccount>({.id = 1, .owner = "Alice", .balance = 10}));
+    _storage.execute(query::insert<TrackedAccount>({.id = 2, .owner = "Bob", .balance = 20}));
+
+    std::vector<TrackedAccount> loaded =
+        _storage.receive(query::select<TrackedAccount>({}).orderBy(&TrackedAccount::id));
+    std::vector<Tracked<TrackedAccount>> accounts = track(std::move(loaded));
+    ASSERT_EQ(accounts.size(), 2);
+
+    accounts[0]->owner = "Carol";
+    EXPECT_TRUE(_storage.update(accounts[0], true));
+    EXPECT_EQ(_connection->changedRows(), 1);
+    EXPECT_FALSE(accounts[0].dirty());
+
+    // nothing to write
+    EXPECT_TRUE(_storage.update(accounts[0], true));
+
+    // another writer changes the balance, the optimistic update reports the conflict and keeps the snapshot
+    Tracked<TrackedAccount> other(*accounts[1]);
+    other->balance = 25;
+    EXPECT_TRUE(_storage.update(other));
+
+    accounts[1]->balance = 30;
+    EXPECT_FALSE(_storage.update(accounts[1], true));
+    EXPECT_EQ(_connection->changedRows(), 0);
+    EXPECT_TRUE(accounts[1].dirty());
+    std::vector<TrackedAccount> data =
+        _storage.receive(query::select<TrackedAccount>({}).where(field(&TrackedAccount::id) == 2));
+    EXPECT_EQ(data.at(0).balance, 25);
+
+    // a removed row can't be updated either
+    _storage.execute(query::remove<TrackedAccount>().where(field(&TrackedAccount::id) == 1));
+    accounts[0]->balance = 0;
+    EXPECT_FALSE(_storage.update(accounts[0]));
+
+    // the count covers every row a statement matches, a read resets it
+    _storage.execute(query::update({&TrackedAccount::balance}, TrackedAccount{.id = 0, .owner = "", .balance = 1}));
+    EXPECT_EQ(_connection->changedRows(), 1);
+    data = _storage.receive(query::select<TrackedAccount>({}));
+    EXPECT_EQ(_connection->changedRows(), 0);
+}
@@ -1,4 +1,5 @@
 #include "testfixture.hh"
+#include <dbfacade/schemeexception.hh>
 
 using namespace softeq;
 
@@ -36,6 +37,12 @@ struct StudentWithOtherDefault : public Student
 {
     // same members
 };
+
+struct Course
+{
+    int id;
+    std::string title;
+};
 } // namespace
 
 template <>
@@ -119,6 +126,19 @@ const db::TableScheme db::buildTableScheme<StudentWithOtherDefault>()
     return scheme;
 }
 
+template <>
+const db::TableScheme db::buildTableScheme<Course>()
+{
+    // clang-format off
+    static const auto scheme = db::TableScheme("course",
+        {
+            {&Course::id, "id", db::Cell::Flags::PRIMARY_KEY},
+            {&Course::title, "title"}
+        }
+    ); // clang-format on
+    return scheme;
+}
+
 #define EXPECT_THROW_WITH_TEXT(operation, exceptionType, expectedText)                                                 \
     do                                                                                                                 \
     {                                                                                                                  \
@@ -204,3 +224,35 @@ TEST_F(DBFacadeTestFixture, VerifyDifferentDefault) // same columns, but differe
     EXPECT_THROW_WITH_TEXT(_storage.verifyScheme<StudentWithOtherDefault>(), SqlException,
                            "Default value '' of column 'name' does not match expected value John Doe");
 }
+
+TEST_F(DBFacadeTestFixture, VerifySchemesGood)
+{
+    using namespace db;
+
+    TableGuard<Student> studentGuard(_storage);
+    TableGuard<Course> courseGuard(_storage);
+    EXPECT_NO_THROW((_storage.verifySchemes<Student, Course>()));
+}
+
+TEST_F(DBFacadeTestFixture, VerifySchemesAllMismatches)
+{
+    using namespace db;
+
+    TableGuard<Student> dbguard(_storage);
+    try
+    {
+        _storage.verifySchemes<StudentMoreColumns, Course>();
+        FAIL() << "Expected to throw an exception";
+    }
+    catch (SchemeException &ex)
+    {
+        ASSERT_EQ(ex.mismatches().size(), 2);
+        EXPECT_EQ(ex.mismatches()[0].table, "student");
+        EXPECT_EQ(ex.mismatches()[0].message, "Column 'time' from scheme does not exist in the table");
+        EXPECT_EQ(ex.mismatches()[1].table, "course");
+        EXPECT_EQ(ex.mismatches()[1].message, "Table 'course' does not exist");
+        EXPECT_STREQ(ex.what(), "2 scheme mismatches found:\n"
+                                "student: Column 'time' from scheme does not exist in the table\n"
+                                "course: Table 'course' does not exist");
+    }
+}